@@ -0,0 +1,161 @@
+#include "cached_window.h"
+
+#include "capture.h"
+#include "imgui.h"
+#include "imgui_internal.h"
+#include "window.h"
+#include <stdint.h>
+#include <unordered_map>
+
+namespace window {
+
+// Draw commands a cached window's UI function added to its draw list,
+// relative to the window's position when they were recorded
+struct recording {
+    bool valid;
+    uint64_t version;
+    ImVec2 pos;
+    ImVec2 size;
+    ImVec2 scroll;
+    // Clamped to the viewport, text outside it was not recorded
+    ImRect clip_rect;
+    ImFontAtlas* fonts;
+    float font_size;
+    // Frame the window was last submitted in
+    int last_frame;
+    // Cursor the function started at and the extent of its content
+    ImVec2 cursor;
+    ImVec2 content;
+    capture::commands draw;
+};
+
+static std::unordered_map<ImGuiID, recording> recordings;
+
+// Everything outside of version the recorded commands depend on
+static bool matches(const recording& r, ImGuiWindow* window) {
+    ImVec2 size = ImGui::GetWindowSize();
+    ImVec2 pos = ImGui::GetWindowPos();
+    ImVec2 offset(pos.x - r.pos.x, pos.y - r.pos.y);
+    const ImRect& clip = window->ClipRect;
+    return r.size.x == size.x && r.size.y == size.y &&
+           r.clip_rect.Min.x + offset.x == clip.Min.x &&
+           r.clip_rect.Min.y + offset.y == clip.Min.y &&
+           r.clip_rect.Max.x + offset.x == clip.Max.x &&
+           r.clip_rect.Max.y + offset.y == clip.Max.y &&
+           r.scroll.x == window->Scroll.x && r.scroll.y == window->Scroll.y &&
+           r.fonts == ImGui::GetIO().Fonts &&
+           r.font_size == ImGui::GetFontSize();
+}
+
+static void record(recording& r, ImGuiWindow* window,
+                   const std::function<void()>& fn) {
+    capture::mark mark = capture::begin(window->DrawList);
+    ImVec2 cursor = ImGui::GetCursorScreenPos();
+
+    fn();
+
+    r.valid = capture::end(window->DrawList, mark, r.draw);
+    r.pos = ImGui::GetWindowPos();
+    r.size = ImGui::GetWindowSize();
+    r.scroll = window->Scroll;
+    r.clip_rect = window->ClipRect;
+    r.fonts = ImGui::GetIO().Fonts;
+    r.font_size = ImGui::GetFontSize();
+    r.cursor = cursor;
+    r.content = ImVec2(window->DC.CursorMaxPos.x - cursor.x,
+                       window->DC.CursorMaxPos.y - cursor.y);
+}
+
+// Appends the recorded commands, moved to where the window is now
+static void replay(const recording& r, ImGuiWindow* window) {
+    ImDrawList* draw_list = window->DrawList;
+    ImVec2 pos = ImGui::GetWindowPos();
+    ImVec2 offset(pos.x - r.pos.x, pos.y - r.pos.y);
+
+    draw_list->PrimReserve(0, r.draw.vertices.Size);
+    unsigned int first_vertex = draw_list->_VtxCurrentIdx;
+    for (const ImDrawVert& v : r.draw.vertices) {
+        ImDrawVert moved = v;
+        moved.pos.x += offset.x;
+        moved.pos.y += offset.y;
+        *draw_list->_VtxWritePtr++ = moved;
+    }
+    draw_list->_VtxCurrentIdx += (unsigned int)r.draw.vertices.Size;
+
+    for (const ImDrawCmd& cmd : r.draw.commands) {
+        if (cmd.UserCallback != nullptr) {
+            draw_list->AddCallback(cmd.UserCallback, cmd.UserCallbackData);
+            continue;
+        }
+        draw_list->PushClipRect(
+            ImVec2(cmd.ClipRect.x + offset.x, cmd.ClipRect.y + offset.y),
+            ImVec2(cmd.ClipRect.z + offset.x, cmd.ClipRect.w + offset.y));
+        draw_list->PushTextureID(cmd.TextureId);
+        draw_list->PrimReserve((int)cmd.ElemCount, 0);
+        const ImDrawIdx* indices = r.draw.indices.Data + cmd.IdxOffset;
+        for (unsigned int n = 0; n < cmd.ElemCount; n++) {
+            *draw_list->_IdxWritePtr++ =
+                (ImDrawIdx)(indices[n] + first_vertex);
+        }
+        draw_list->PopTextureID();
+        draw_list->PopClipRect();
+    }
+
+    // Items fn would have submitted size the window's content
+    ImGui::SetCursorScreenPos(
+        ImVec2(r.cursor.x + offset.x, r.cursor.y + offset.y));
+    ImGui::Dummy(r.content);
+}
+
+void cached_window(const char* name, uint64_t version,
+                   const std::function<void()>& fn, int flags) {
+    if (!ImGui::Begin(name, nullptr, flags)) {
+        // Collapsed, the recording is still good once it is expanded
+        auto it = recordings.find(ImGui::GetCurrentWindow()->ID);
+        if (it != recordings.end()) {
+            it->second.last_frame = ImGui::GetFrameCount();
+        }
+        ImGui::End();
+        return;
+    }
+    ImGuiWindow* window = ImGui::GetCurrentWindow();
+    recording& r = recordings[window->ID];
+    r.last_frame = ImGui::GetFrameCount();
+
+    // Widgets only react to input while fn runs, so interaction runs it
+    int hovered_flags = ImGuiHoveredFlags_ChildWindows |
+                        ImGuiHoveredFlags_AllowWhenBlockedByActiveItem;
+    bool interacting = ImGui::IsWindowHovered(hovered_flags) ||
+                       ImGui::IsWindowFocused(ImGuiFocusedFlags_ChildWindows) ||
+                       ImGui::IsWindowAppearing();
+    // The vertices have to fit behind the list's current ones
+    unsigned int vertices = window->DrawList->_VtxCurrentIdx;
+    bool fits = sizeof(ImDrawIdx) > 2 ||
+                vertices + (unsigned int)r.draw.vertices.Size < (1u << 16);
+    if (r.valid && r.version == version && !interacting && fits &&
+        matches(r, window)) {
+        replay(r, window);
+    } else {
+        record(r, window, fn);
+        r.version = version;
+    }
+    ImGui::End();
+}
+
+namespace cached_windows {
+
+void end_frame() {
+    int frame = ImGui::GetFrameCount();
+    for (auto it = recordings.begin(); it != recordings.end();) {
+        if (it->second.last_frame != frame) {
+            it = recordings.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void shutdown() { recordings.clear(); }
+
+} // namespace cached_windows
+} // namespace window
@@ -0,0 +1,18 @@
+#pragma once
+
+// Recordings behind window::cached_window().
+//
+// Each cached window keeps the draw commands its UI function added last
+// time. Recordings of windows that were not submitted in a frame are
+// dropped at its end, so closed windows do not hold on to their commands.
+
+namespace window {
+namespace cached_windows {
+
+// Drop the recordings of windows not submitted this frame. Before
+// ImGui::Render().
+void end_frame();
+void shutdown();
+
+} // namespace cached_windows
+} // namespace window
@@ -0,0 +1,85 @@
+#include "capture.h"
+
+#include <string.h>
+
+namespace window {
+namespace capture {
+
+mark begin(const ImDrawList* draw_list) {
+    mark m;
+    m.command_count = draw_list->CmdBuffer.Size;
+    m.last[0] = m.command_count > 1 ? draw_list->CmdBuffer[m.command_count - 2]
+                                    : ImDrawCmd();
+    m.last[1] = draw_list->CmdBuffer[m.command_count - 1];
+    m.header = draw_list->_CmdHeader;
+    m.first_vertex = draw_list->_VtxCurrentIdx;
+    m.vertex_count = draw_list->VtxBuffer.Size;
+    m.index_count = draw_list->IdxBuffer.Size;
+    return m;
+}
+
+bool end(const ImDrawList* draw_list, const mark& m, commands& out) {
+    out.vertices.resize(0);
+    out.indices.resize(0);
+    out.commands.resize(0);
+
+    // Changing the clip rect or texture may merge an empty last command
+    // into the one before it, so the new indices can start in either. The
+    // last command may also have become a callback if it was empty.
+    int first = m.command_count > 1 ? m.command_count - 2 : 0;
+    for (int i = first; i < draw_list->CmdBuffer.Size; i++) {
+        ImDrawCmd cmd = draw_list->CmdBuffer[i];
+        if (cmd.VtxOffset != m.header.VtxOffset) {
+            return false;
+        }
+        if (cmd.UserCallback != nullptr) {
+            bool added = i >= m.command_count ||
+                         (i == m.command_count - 1 &&
+                          m.last[1].UserCallback == nullptr);
+            if (added) {
+                cmd.IdxOffset = (unsigned int)out.indices.Size;
+                out.commands.push_back(cmd);
+            }
+            continue;
+        }
+        unsigned int start = cmd.IdxOffset < (unsigned int)m.index_count
+                                 ? (unsigned int)m.index_count
+                                 : cmd.IdxOffset;
+        unsigned int end = cmd.IdxOffset + cmd.ElemCount;
+        if (end <= start) {
+            continue;
+        }
+        cmd.IdxOffset = (unsigned int)out.indices.Size;
+        cmd.VtxOffset = 0;
+        cmd.ElemCount = end - start;
+        for (unsigned int n = start; n < end; n++) {
+            out.indices.push_back(
+                (ImDrawIdx)(draw_list->IdxBuffer[(int)n] - m.first_vertex));
+        }
+        out.commands.push_back(cmd);
+    }
+
+    out.vertices.resize(draw_list->VtxBuffer.Size - m.vertex_count);
+    if (!out.vertices.empty()) {
+        memcpy(out.vertices.Data, draw_list->VtxBuffer.Data + m.vertex_count,
+               (size_t)out.vertices.size_in_bytes());
+    }
+    return true;
+}
+
+void discard(ImDrawList* draw_list, const mark& m) {
+    draw_list->CmdBuffer.resize(m.command_count);
+    if (m.command_count > 1) {
+        draw_list->CmdBuffer[m.command_count - 2] = m.last[0];
+    }
+    draw_list->CmdBuffer[m.command_count - 1] = m.last[1];
+    draw_list->_CmdHeader = m.header;
+    draw_list->VtxBuffer.resize(m.vertex_count);
+    draw_list->IdxBuffer.resize(m.index_count);
+    draw_list->_VtxWritePtr = draw_list->VtxBuffer.Data + m.vertex_count;
+    draw_list->_IdxWritePtr = draw_list->IdxBuffer.Data + m.index_count;
+    draw_list->_VtxCurrentIdx = m.first_vertex;
+}
+
+} // namespace capture
+} // namespace window
@@ -0,0 +1,40 @@
+#pragma once
+
+// Copies the draw commands a piece of UI code adds to a draw list, for
+// replaying them later or rendering them elsewhere.
+
+#include "imgui.h"
+
+namespace window {
+namespace capture {
+
+// Draw list state before the captured code runs
+struct mark {
+    int command_count;
+    // The last two commands, which ImDrawList may still change or merge
+    ImDrawCmd last[2];
+    ImDrawCmdHeader header;
+    unsigned int first_vertex;
+    int vertex_count;
+    int index_count;
+};
+
+// Draw commands with indices relative to the first vertex. IdxOffset is
+// into indices and VtxOffset is 0.
+struct commands {
+    ImVector<ImDrawVert> vertices;
+    ImVector<ImDrawIdx> indices;
+    ImVector<ImDrawCmd> commands;
+};
+
+mark begin(const ImDrawList* draw_list);
+
+// Copy what was added since begin(). Returns false when the commands can't
+// be captured, because the list moved on to another vertex offset.
+bool end(const ImDrawList* draw_list, const mark& m, commands& out);
+
+// Drop what was added since begin() from the list again
+void discard(ImDrawList* draw_list, const mark& m);
+
+} // namespace capture
+} // namespace window
@@ -0,0 +1,335 @@
+#include "damage.h"
+
+#include "imgui.h"
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+namespace window {
+namespace damage {
+
+// EGL is reached through SDL_GL_GetProcAddress() so the build does not need
+// its headers, these are the few declarations used from egl.h/eglext.h.
+typedef void* egl_display;
+typedef void* egl_surface;
+typedef int32_t egl_int;
+typedef unsigned int egl_boolean;
+typedef egl_display (*get_current_display_fn)(void);
+typedef egl_surface (*get_current_surface_fn)(egl_int readdraw);
+typedef const char* (*query_string_fn)(egl_display display, egl_int name);
+typedef egl_boolean (*query_surface_fn)(egl_display display,
+                                        egl_surface surface,
+                                        egl_int attribute, egl_int* value);
+typedef egl_boolean (*swap_with_damage_fn)(egl_display display,
+                                           egl_surface surface,
+                                           egl_int* rects, egl_int n_rects);
+static const egl_int egl_extensions = 0x3055;
+static const egl_int egl_draw = 0x3059;
+static const egl_int egl_buffer_age = 0x313D;
+
+// Lists beyond this many damaged rectangles are redrawn as their union
+static const size_t max_rects = 8;
+// Damage is kept for back buffers up to this many frames old
+static const size_t max_age = 4;
+
+struct list_state {
+    const ImDrawList* list;
+    uint64_t hash;
+    // Display coordinates, empty when x > z
+    ImVec4 bounds;
+};
+
+struct frame_damage {
+    bool full;
+    std::vector<ImVec4> rects;
+};
+
+static egl_display display;
+static egl_surface surface;
+static query_surface_fn query_surface;
+static swap_with_damage_fn swap_with_damage;
+
+static std::vector<list_state> previous;
+static ImVec2 previous_display_pos;
+static ImVec2 previous_display_size;
+static ImVec2 previous_framebuffer_scale;
+// Newest first, history[0] is the damage of the current frame
+static std::vector<frame_damage> history;
+// Passed to add() for the current frame
+static std::vector<ImVec4> added;
+
+static bool has_token(const char* list, const char* name) {
+    size_t length = strlen(name);
+    for (const char* s = list; s && (s = strstr(s, name)); s += length) {
+        if ((s == list || s[-1] == ' ') &&
+            (s[length] == ' ' || s[length] == '\0')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void init(SDL_Window*) {
+    // Only these SDL video drivers render through EGL. Elsewhere
+    // SDL_GL_GetProcAddress() may hand out stubs for unknown names.
+    static const char* const egl_drivers[] = {"wayland", "KMSDRM", "RPI",
+                                              "vivante"};
+    const char* driver = SDL_GetCurrentVideoDriver();
+    bool egl = false;
+    for (const char* name : egl_drivers) {
+        egl = egl || (driver && SDL_strcasecmp(driver, name) == 0);
+    }
+    if (!egl) {
+        return;
+    }
+
+    auto get_current_display = (get_current_display_fn)SDL_GL_GetProcAddress(
+        "eglGetCurrentDisplay");
+    auto get_current_surface = (get_current_surface_fn)SDL_GL_GetProcAddress(
+        "eglGetCurrentSurface");
+    auto query_string =
+        (query_string_fn)SDL_GL_GetProcAddress("eglQueryString");
+    if (!get_current_display || !get_current_surface || !query_string) {
+        return;
+    }
+    display = get_current_display();
+    surface = get_current_surface(egl_draw);
+    const char* extensions = query_string(display, egl_extensions);
+    if (!has_token(extensions, "EGL_EXT_buffer_age")) {
+        return;
+    }
+    query_surface = (query_surface_fn)SDL_GL_GetProcAddress("eglQuerySurface");
+
+    // On Wayland SDL_GL_SwapWindow() also paces frames with the
+    // compositor's frame callbacks, so it is not bypassed there.
+    if (SDL_strcasecmp(driver, "wayland") == 0) {
+        return;
+    }
+    if (has_token(extensions, "EGL_KHR_swap_buffers_with_damage")) {
+        swap_with_damage = (swap_with_damage_fn)SDL_GL_GetProcAddress(
+            "eglSwapBuffersWithDamageKHR");
+    } else if (has_token(extensions, "EGL_EXT_swap_buffers_with_damage")) {
+        swap_with_damage = (swap_with_damage_fn)SDL_GL_GetProcAddress(
+            "eglSwapBuffersWithDamageEXT");
+    }
+}
+
+static uint64_t hash_bytes(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* p = (const unsigned char*)data;
+    for (; size >= 8; p += 8, size -= 8) {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        hash = (hash ^ word) * 0x100000001b3ull;
+        hash ^= hash >> 29;
+    }
+    for (; size > 0; p++, size--) {
+        hash = (hash ^ *p) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static bool is_empty(const ImVec4& r) { return r.x >= r.z || r.y >= r.w; }
+
+static bool overlaps(const ImVec4& a, const ImVec4& b) {
+    return a.x <= b.z && b.x <= a.z && a.y <= b.w && b.y <= a.w;
+}
+
+static ImVec4 intersect(const ImVec4& a, const ImVec4& b) {
+    return ImVec4(std::max(a.x, b.x), std::max(a.y, b.y), std::min(a.z, b.z),
+                  std::min(a.w, b.w));
+}
+
+static ImVec4 combine(const ImVec4& a, const ImVec4& b) {
+    return ImVec4(std::min(a.x, b.x), std::min(a.y, b.y), std::max(a.z, b.z),
+                  std::max(a.w, b.w));
+}
+
+// The list below it is part of the hash, so a change in z-order damages
+// the lists that moved.
+static list_state measure(const ImDrawList* list, const ImDrawList* below) {
+    list_state s = {list, 0xcbf29ce484222325ull,
+                    ImVec4(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX)};
+    s.hash = hash_bytes(s.hash, &below, sizeof(below));
+    s.hash = hash_bytes(s.hash, list->VtxBuffer.Data,
+                        (size_t)list->VtxBuffer.size_in_bytes());
+    s.hash = hash_bytes(s.hash, list->IdxBuffer.Data,
+                        (size_t)list->IdxBuffer.size_in_bytes());
+    s.hash = hash_bytes(s.hash, list->CmdBuffer.Data,
+                        (size_t)list->CmdBuffer.size_in_bytes());
+
+    ImVec4 vertices = s.bounds;
+    for (const ImDrawVert& v : list->VtxBuffer) {
+        vertices = combine(vertices, ImVec4(v.pos.x, v.pos.y, v.pos.x,
+                                            v.pos.y));
+    }
+    ImVec4 clip = s.bounds;
+    for (const ImDrawCmd& cmd : list->CmdBuffer) {
+        if (cmd.UserCallback == nullptr) {
+            clip = combine(clip, cmd.ClipRect);
+        }
+    }
+    s.bounds = intersect(vertices, clip);
+    return s;
+}
+
+static void add(std::vector<ImVec4>& rects, const ImVec4& r) {
+    if (!is_empty(r)) {
+        rects.push_back(r);
+    }
+}
+
+static void merge(std::vector<ImVec4>& rects) {
+    for (bool merged = true; merged;) {
+        merged = false;
+        for (size_t i = 0; i < rects.size(); i++) {
+            for (size_t j = i + 1; j < rects.size(); j++) {
+                if (overlaps(rects[i], rects[j])) {
+                    rects[i] = combine(rects[i], rects[j]);
+                    rects.erase(rects.begin() + j);
+                    merged = true;
+                    j--;
+                }
+            }
+        }
+    }
+    if (rects.size() > max_rects) {
+        ImVec4 all = rects[0];
+        for (const ImVec4& r : rects) {
+            all = combine(all, r);
+        }
+        rects.assign(1, all);
+    }
+}
+
+// Damage of this frame against the last one, in display coordinates
+static frame_damage diff(ImDrawData* draw_data) {
+    frame_damage damage;
+    damage.full = previous.empty() ||
+                  draw_data->DisplayPos.x != previous_display_pos.x ||
+                  draw_data->DisplayPos.y != previous_display_pos.y ||
+                  draw_data->DisplaySize.x != previous_display_size.x ||
+                  draw_data->DisplaySize.y != previous_display_size.y ||
+                  draw_data->FramebufferScale.x !=
+                      previous_framebuffer_scale.x ||
+                  draw_data->FramebufferScale.y != previous_framebuffer_scale.y;
+    previous_display_pos = draw_data->DisplayPos;
+    previous_display_size = draw_data->DisplaySize;
+    previous_framebuffer_scale = draw_data->FramebufferScale;
+
+    std::vector<list_state> current;
+    std::vector<bool> matched(previous.size(), false);
+    const ImDrawList* below = nullptr;
+    for (int n = 0; n < draw_data->CmdListsCount; n++) {
+        const ImDrawList* list = draw_data->CmdLists[n];
+        list_state s = measure(list, below);
+        below = list;
+        current.push_back(s);
+
+        size_t i = 0;
+        while (i < previous.size() && previous[i].list != list) {
+            i++;
+        }
+        if (i == previous.size()) {
+            add(damage.rects, s.bounds);
+            continue;
+        }
+        matched[i] = true;
+        if (previous[i].hash != s.hash) {
+            add(damage.rects, previous[i].bounds);
+            add(damage.rects, s.bounds);
+        }
+    }
+    for (size_t i = 0; i < previous.size(); i++) {
+        if (!matched[i]) {
+            add(damage.rects, previous[i].bounds);
+        }
+    }
+    previous.swap(current);
+    damage.rects.insert(damage.rects.end(), added.begin(), added.end());
+    added.clear();
+    return damage;
+}
+
+void add(const ImVec4& rect) { add(added, rect); }
+
+void reset() {
+    added.clear();
+    // The next diff() is full, and so are the buffers drawn until then
+    previous.clear();
+    history.insert(history.begin(), frame_damage{true, {}});
+    if (history.size() > max_age) {
+        history.pop_back();
+    }
+}
+
+bool update(ImDrawData* draw_data, ImVector<ImVec4>& rects) {
+    rects.clear();
+    if (query_surface == nullptr) {
+        added.clear();
+        return false;
+    }
+    egl_int age = 0;
+    if (!query_surface(display, surface, egl_buffer_age, &age)) {
+        age = 0;
+    }
+
+    history.insert(history.begin(), diff(draw_data));
+    if (history.size() > max_age) {
+        history.pop_back();
+    }
+
+    // The back buffer holds the frame drawn age swaps ago, everything
+    // damaged since has to be redrawn. An age of 0 means undefined content.
+    if (age <= 0 || (size_t)age > history.size()) {
+        return false;
+    }
+    // To whole framebuffer pixels, antialiased edges bleed half a pixel.
+    // Merged only after rounding so the results cannot overlap.
+    ImVec2 pos = draw_data->DisplayPos;
+    ImVec2 scale = draw_data->FramebufferScale;
+    ImVec4 framebuffer(0.0f, 0.0f, draw_data->DisplaySize.x * scale.x,
+                       draw_data->DisplaySize.y * scale.y);
+    std::vector<ImVec4> damaged;
+    for (size_t i = 0; i < (size_t)age; i++) {
+        if (history[i].full) {
+            return false;
+        }
+        for (const ImVec4& r : history[i].rects) {
+            ImVec4 pixels(floorf((r.x - pos.x) * scale.x) - 1.0f,
+                          floorf((r.y - pos.y) * scale.y) - 1.0f,
+                          ceilf((r.z - pos.x) * scale.x) + 1.0f,
+                          ceilf((r.w - pos.y) * scale.y) + 1.0f);
+            add(damaged, intersect(pixels, framebuffer));
+        }
+    }
+    merge(damaged);
+    for (const ImVec4& r : damaged) {
+        rects.push_back(r);
+    }
+    return true;
+}
+
+void swap(SDL_Window* window, bool full, const ImVector<ImVec4>& rects) {
+    // No rectangles would mean the whole surface to EGL
+    if (swap_with_damage == nullptr || full || rects.empty()) {
+        SDL_GL_SwapWindow(window);
+        return;
+    }
+    int height = 0;
+    SDL_GL_GetDrawableSize(window, nullptr, &height);
+    std::vector<egl_int> boxes;
+    for (const ImVec4& r : rects) {
+        // EGL rectangles have a bottom left origin
+        boxes.push_back((egl_int)r.x);
+        boxes.push_back((egl_int)(height - r.w));
+        boxes.push_back((egl_int)(r.z - r.x));
+        boxes.push_back((egl_int)(r.w - r.y));
+    }
+    swap_with_damage(display, surface, boxes.data(), (egl_int)rects.Size);
+}
+
+} // namespace damage
+} // namespace window
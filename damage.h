@@ -0,0 +1,40 @@
+#pragma once
+
+// Partial redraw of the main window.
+//
+// Every draw list is hashed and bounded each frame. Lists that changed,
+// moved in the z-order, appeared or disappeared damage their old and new
+// bounds, and only the damaged rectangles are cleared and redrawn. This
+// needs the age of the back buffer (EGL_EXT_buffer_age) to know which
+// earlier frames' damage it is missing, so it is only used where SDL renders
+// through EGL. Everywhere else, and whenever the age is unknown, the whole
+// window is redrawn.
+
+#include "imgui.h"
+#include <SDL.h>
+
+namespace window {
+namespace damage {
+
+// After the window's context is made current
+void init(SDL_Window* window);
+
+// Rectangles to redraw this frame, in framebuffer pixels with a top left
+// origin like ImDrawCmd::ClipRect. Returns false when the whole framebuffer
+// has to be redrawn, an empty vector means nothing changed.
+bool update(ImDrawData* draw_data, ImVector<ImVec4>& rects);
+
+// Mark a rectangle in display coordinates as changed this frame, for
+// content the draw lists don't reflect such as a re-rendered texture
+void add(const ImVec4& rect);
+
+// Forget the damage of this frame instead of update(), when the whole
+// framebuffer is redrawn for reasons damage tracking cannot see
+void reset();
+
+// Present the window, passing the damage to the compositor where supported.
+// full and rects as returned by update().
+void swap(SDL_Window* window, bool full, const ImVector<ImVec4>& rects);
+
+} // namespace damage
+} // namespace window
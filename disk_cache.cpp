@@ -0,0 +1,63 @@
+#include "disk_cache.h"
+
+#include <SDL.h>
+#include <stdio.h>
+#include <string>
+
+namespace window {
+namespace disk_cache {
+
+// Empty when SDL has no writable directory for us
+static std::string path(const char* name) {
+    char* dir = SDL_GetPrefPath("imgui-boilerplate", "cache");
+    if (dir == nullptr) {
+        return "";
+    }
+    std::string result = std::string(dir) + name;
+    SDL_free(dir);
+    return result;
+}
+
+std::vector<char> read(const char* name) {
+    std::vector<char> data;
+    std::string file = path(name);
+    FILE* f = file.empty() ? nullptr : fopen(file.c_str(), "rb");
+    if (f == nullptr) {
+        return data;
+    }
+    if (fseek(f, 0, SEEK_END) == 0) {
+        long size = ftell(f);
+        if (size > 0 && fseek(f, 0, SEEK_SET) == 0) {
+            data.resize((size_t)size);
+            if (fread(data.data(), 1, data.size(), f) != data.size()) {
+                data.clear();
+            }
+        }
+    }
+    fclose(f);
+    return data;
+}
+
+void write(const char* name, const std::vector<char>& data) {
+    std::string file = path(name);
+    if (file.empty()) {
+        return;
+    }
+    std::string temporary = file + ".tmp";
+    FILE* f = fopen(temporary.c_str(), "wb");
+    if (f == nullptr) {
+        fprintf(stderr, "Could not write %s\n", temporary.c_str());
+        return;
+    }
+    bool written = fwrite(data.data(), 1, data.size(), f) == data.size();
+    written = fclose(f) == 0 && written;
+    // rename() does not replace existing files on Windows
+    remove(file.c_str());
+    if (!written || rename(temporary.c_str(), file.c_str()) != 0) {
+        fprintf(stderr, "Could not write %s\n", file.c_str());
+        remove(temporary.c_str());
+    }
+}
+
+} // namespace disk_cache
+} // namespace window
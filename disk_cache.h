@@ -0,0 +1,21 @@
+#pragma once
+
+// Small files kept between runs to speed up startup, in the per-user
+// directory SDL_GetPrefPath() gives the boilerplate. Everything in it can
+// be deleted at any time.
+
+#include <vector>
+
+namespace window {
+namespace disk_cache {
+
+// Contents of the cache file name, empty when there is none
+std::vector<char> read(const char* name);
+
+// Replace the cache file name. Written to a temporary file first so a crash
+// never leaves half a file behind. Failures are only reported, a missing
+// cache costs startup time but nothing else.
+void write(const char* name, const std::vector<char>& data);
+
+} // namespace disk_cache
+} // namespace window
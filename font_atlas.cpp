@@ -0,0 +1,333 @@
+#include "font_atlas.h"
+
+#include "font_builder.h"
+#include "imgui.h"
+#include "opengl.h"
+#include "sdf_font.h"
+#include "software_renderer.h"
+#include "startup_profile.h"
+#include <chrono>
+#include <future>
+#include <math.h>
+#include <stdint.h>
+#include <vector>
+
+#if defined(IMGUI_BOILERPLATE_GLYPH_RANGES)
+// Subset at build time to the ranges in IMGUI_BOILERPLATE_GLYPH_RANGES
+#include "subset_fonts/FiraMono_Regular.h"
+#include "subset_fonts/FiraSans_Regular.h"
+#include "subset_fonts/glyph_ranges.h"
+#else
+#include "fonts/FiraMono_Regular.h"
+#include "fonts/FiraSans_Regular.h"
+static const ImWchar* const glyph_ranges = nullptr;
+#endif
+
+namespace window {
+namespace font_atlas {
+
+// Atlases are cached in quarter steps so small DPI differences between
+// monitors do not trigger a rebuild.
+static const float scale_step = 0.25f;
+static const float min_scale = 0.5f;
+static const float max_scale = 4.0f;
+
+// The embedded fonts, registered as window::default_font, heading_font
+// and text_font
+static std::vector<font_spec> specs = {
+    {FiraMono_Regular_compressed_data, (int)FiraMono_Regular_compressed_size,
+     16.0f, glyph_ranges, false},
+    {FiraSans_Regular_compressed_data, (int)FiraSans_Regular_compressed_size,
+     22.0f, glyph_ranges, true},
+    {FiraSans_Regular_compressed_data, (int)FiraSans_Regular_compressed_size,
+     18.0f, glyph_ranges, true},
+};
+
+static std::vector<entry*> cache;
+static entry* current;
+// Used until the first full atlas is ready, see init_progressive()
+static entry* minimal;
+static std::future<entry*> pending;
+// Upload atlases as GL_R8. Needs the context to decide, set by init()
+static bool alpha_only;
+static textures texture_mode;
+
+static float quantize(float scale) {
+    if (!(scale > 0.0f)) {
+        return 1.0f;
+    }
+    scale = roundf(scale / scale_step) * scale_step;
+    return scale < min_scale ? min_scale
+                             : (scale > max_scale ? max_scale : scale);
+}
+
+int add_font(const font_spec& spec) {
+    IM_ASSERT(cache.empty() && "Fonts must be added before window::init()");
+    specs.push_back(spec);
+    return (int)specs.size() - 1;
+}
+
+const font_spec& get_font(int id) { return specs[id]; }
+
+static entry* find(float scale) {
+    for (entry* e : cache) {
+        if (e->scale == scale) {
+            return e;
+        }
+    }
+    return nullptr;
+}
+
+// Decompress every registered font into the atlas
+static void add_fonts(entry* e, float scale) {
+    for (const font_spec& spec : specs) {
+        ImFont* font = nullptr;
+#if defined(IMGUI_BOILERPLATE_SDF_FONTS)
+        if (spec.sdf && texture_mode == textures::opengl) {
+            // a single distance field font serves every size of a typeface
+            for (size_t i = 0; i < e->fonts.size() && font == nullptr; i++) {
+                if (specs[i].sdf &&
+                    specs[i].compressed_ttf == spec.compressed_ttf) {
+                    font = e->fonts[i];
+                }
+            }
+            if (font == nullptr) {
+                font = sdf::add_font(e->atlas, spec.compressed_ttf,
+                                     spec.compressed_ttf_size,
+                                     spec.glyph_ranges);
+            }
+        }
+#endif
+        if (font == nullptr) {
+            font = e->atlas->AddFontFromMemoryCompressedTTF(
+                spec.compressed_ttf, spec.compressed_ttf_size,
+                spec.size * scale, nullptr, spec.glyph_ranges);
+        }
+        e->fonts.push_back(font);
+    }
+}
+
+// Runs on a worker thread, see prepare() and update(). Building an atlas
+// touches no ImGui context state, GImGui is null on workers (see
+// imgui_config.h) so ImGui::MemAlloc() does not count its allocations.
+// rgba converts the pixels for an RGBA upload, otherwise upload() does when
+// it has to.
+static entry* build(float scale, bool rgba) {
+    entry* e = new entry();
+    e->scale = scale;
+    e->atlas = IM_NEW(ImFontAtlas)();
+    e->atlas->FontBuilderIO = font_builder::parallel();
+
+    // All roles go into the atlas before a single build
+    {
+        startup_profile::scope phase("font decompression");
+        add_fonts(e, scale);
+    }
+    startup_profile::scope phase("atlas build");
+#if defined(IMGUI_BOILERPLATE_SDF_FONTS)
+    sdf::build(e->atlas);
+#else
+    e->atlas->Build();
+#endif
+
+    if (rgba) {
+        // Convert to RGBA here rather than on the render thread
+        unsigned char* pixels;
+        int width, height;
+        e->atlas->GetTexDataAsRGBA32(&pixels, &width, &height);
+    }
+    return e;
+}
+
+// Swizzling needs OpenGL 3.3, OpenGL ES 3.0 or GL_ARB_texture_swizzle
+static bool has_texture_swizzle() {
+#if defined(IMGUI_IMPL_OPENGL_ES2)
+    return false;
+#elif defined(IMGUI_IMPL_OPENGL_ES3)
+    return gl::has_version(3, 0);
+#else
+    return gl::has_version(3, 3) ||
+           gl::has_extension("GL_ARB_texture_swizzle");
+#endif
+}
+
+// Same texture setup as ImGui_ImplOpenGL3_CreateFontsTexture(), except for
+// the format
+static void upload(entry* e) {
+    unsigned char* pixels;
+    int width, height;
+    // Coloured glyphs need the full RGBA texture
+    bool alpha = alpha_only && !e->atlas->TexPixelsUseColors;
+    if (alpha) {
+        e->atlas->GetTexDataAsAlpha8(&pixels, &width, &height);
+    } else {
+        e->atlas->GetTexDataAsRGBA32(&pixels, &width, &height);
+    }
+
+    if (texture_mode == textures::backend) {
+        e->texture = 0;
+        return;
+    }
+    if (texture_mode == textures::software) {
+        e->texture = 0;
+        e->atlas->SetTexID(
+            software::create_texture(pixels, width, height, alpha));
+        e->atlas->ClearTexData();
+        return;
+    }
+
+    GLuint texture;
+    glGenTextures(1, &texture);
+    gl::bind_texture(texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+#ifdef GL_UNPACK_ROW_LENGTH
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+#endif
+#if !defined(IMGUI_IMPL_OPENGL_ES2)
+    if (alpha) {
+        // Samples as (1, 1, 1, coverage), the same as the RGBA32 atlas, so
+        // neither the renderer nor the distance field shader need to change
+        GLint last_alignment;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &last_alignment);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_R, GL_ONE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, GL_ONE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_ONE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_A, GL_RED);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED,
+                     GL_UNSIGNED_BYTE, pixels);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, last_alignment);
+    } else
+#endif
+    {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
+                     GL_UNSIGNED_BYTE, pixels);
+    }
+
+    e->texture = texture;
+    e->atlas->SetTexID((ImTextureID)(intptr_t)texture);
+    // Glyph rects and UVs stay, only the pixels are released
+    e->atlas->ClearTexData();
+}
+
+// ImGui's embedded default font standing in for every role. It is tiny and
+// decompresses in well under a millisecond.
+static entry* build_minimal(float scale) {
+    entry* e = new entry();
+    e->scale = scale;
+    e->minimal = true;
+    e->atlas = IM_NEW(ImFontAtlas)();
+    ImFontConfig config;
+    config.SizePixels = floorf(13.0f * scale);
+    ImFont* font = e->atlas->AddFontDefault(&config);
+    e->fonts.assign(specs.size(), font);
+    e->atlas->Build();
+    if (!alpha_only) {
+        unsigned char* pixels;
+        int width, height;
+        e->atlas->GetTexDataAsRGBA32(&pixels, &width, &height);
+    }
+    return e;
+}
+
+static void destroy(entry* e) {
+    if (texture_mode == textures::software) {
+        software::destroy_texture(e->atlas->TexID);
+    } else if (texture_mode == textures::opengl) {
+        GLuint texture = e->texture;
+        glDeleteTextures(1, &texture);
+        gl::deleted_texture(texture);
+    }
+    IM_DELETE(e->atlas);
+    delete e;
+}
+
+static void choose_format() {
+    // The software renderer samples coverage as white itself, backends
+    // other than OpenGL take RGBA
+    if (texture_mode == textures::opengl) {
+        alpha_only = has_texture_swizzle();
+    } else {
+        alpha_only = texture_mode == textures::software;
+    }
+}
+
+void prepare(float scale, textures mode) {
+    texture_mode = mode;
+    // Whether OpenGL can sample a single channel texture as white is not
+    // known without the context, those atlases are converted on upload
+    pending = std::async(std::launch::async, build, quantize(scale),
+                         mode == textures::backend);
+}
+
+entry* init(float scale, textures mode) {
+    if (!pending.valid()) {
+        prepare(scale, mode);
+    }
+    choose_format();
+    {
+        // Only on the critical path when the fonts take longer than
+        // setting up the window and context
+        startup_profile::scope phase("wait for fonts");
+        pending.wait();
+    }
+    current = pending.get();
+    {
+        startup_profile::scope phase("texture upload");
+        upload(current);
+    }
+    cache.push_back(current);
+    return current;
+}
+
+entry* init_progressive(float scale, textures mode) {
+    if (!pending.valid()) {
+        prepare(scale, mode);
+    }
+    choose_format();
+    startup_profile::scope phase("minimal atlas");
+    minimal = build_minimal(quantize(scale));
+    upload(minimal);
+    current = minimal;
+    return current;
+}
+
+entry* update(float scale) {
+    if (pending.valid() && pending.wait_for(std::chrono::seconds(0)) ==
+                               std::future_status::ready) {
+        entry* e = pending.get();
+        upload(e);
+        cache.push_back(e);
+    }
+    scale = quantize(scale);
+    if (current->scale != scale || current == minimal) {
+        if (entry* e = find(scale)) {
+            current = e;
+        } else if (!pending.valid()) {
+            pending =
+                std::async(std::launch::async, build, scale, !alpha_only);
+        }
+    }
+    return current;
+}
+
+void shutdown() {
+    if (pending.valid()) {
+        entry* e = pending.get();
+        IM_DELETE(e->atlas);
+        delete e;
+    }
+    for (entry* e : cache) {
+        destroy(e);
+    }
+    if (minimal != nullptr) {
+        destroy(minimal);
+    }
+    cache.clear();
+    current = nullptr;
+    minimal = nullptr;
+}
+
+} // namespace font_atlas
+} // namespace window
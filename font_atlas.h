@@ -0,0 +1,78 @@
+#pragma once
+
+// Font atlases rasterised per display scale.
+//
+// Every registered font is baked into a single atlas per scale. Atlases are
+// built on a worker thread when the window moves to a display with a
+// different DPI, and cached so moving back does not rebuild them.
+//
+// Atlas textures are uploaded as a single channel texture where the driver
+// supports swizzling it to white with coverage in alpha. The CPU side pixels
+// are freed once uploaded.
+
+#include "imgui.h"
+#include <vector>
+
+namespace window {
+namespace font_atlas {
+
+// A font role registered before init(), see window::add_font()
+struct font_spec {
+    const void* compressed_ttf;
+    int compressed_ttf_size;
+    float size;
+    const ImWchar* glyph_ranges;
+    // Shares a distance field font with every other role using the same TTF
+    bool sdf;
+};
+
+// Register a font and return its role id. Ids index entry::fonts.
+int add_font(const font_spec& spec);
+const font_spec& get_font(int id);
+
+struct entry {
+    float scale;
+    ImFontAtlas* atlas;
+    std::vector<ImFont*> fonts;
+    unsigned int texture;
+    // ImGui's default font for every role, see init_progressive()
+    bool minimal;
+};
+
+// What atlas textures are made for
+enum class textures {
+    opengl,
+    // window::software textures
+    software,
+    // None, the renderer backend uploads the atlas itself from its RGBA
+    // pixels, which are kept
+    backend,
+};
+
+// Start building the atlas for the initial display scale on a worker
+// thread. Needs neither the window nor a context, so the caller can set
+// those up and compile shaders meanwhile.
+void prepare(float scale, textures mode);
+
+// Upload the atlas built by prepare(), which is called here with the same
+// arguments if it was not before. On the thread that has the OpenGL context
+// current for opengl textures.
+// Distance field fonts need the OpenGL renderer, for other textures they
+// are rasterised normally.
+entry* init(float scale, textures mode);
+
+// Like init(), but returns at once with a minimal atlas holding only
+// ImGui's default font, which every role uses. The registered fonts are
+// built on a worker thread and update() switches to them once uploaded.
+entry* init_progressive(float scale, textures mode);
+
+// Called once per frame before ImGui::NewFrame(). Returns the atlas to
+// render with: the one for scale if it is cached, otherwise the current one
+// while the atlas for scale is built in the background.
+entry* update(float scale);
+
+// Release every cached atlas and texture, after ImGui::DestroyContext().
+void shutdown();
+
+} // namespace font_atlas
+} // namespace window
@@ -0,0 +1,317 @@
+#include "font_builder.h"
+
+#include "imgui.h"
+#include "imgui_internal.h"
+#include "thread_pool.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// Same configuration as the copies compiled into imgui_draw.cpp so packing
+// and rasterisation give identical results. Runs on worker threads, where
+// ImGui::MemAlloc() counts nothing as GImGui is null there (imgui_config.h).
+#define STBRP_STATIC
+#define STBRP_ASSERT(x) IM_ASSERT(x)
+#define STBRP_SORT qsort
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "imstb_rectpack.h"
+
+#define STBTT_assert(x) IM_ASSERT(x)
+#define STBTT_fmod(x, y) ImFmod(x, y)
+#define STBTT_sqrt(x) ImSqrt(x)
+#define STBTT_pow(x, y) ImPow(x, y)
+#define STBTT_fabs(x) ImFabs(x)
+#define STBTT_ifloor(x) ((int)floorf(x))
+#define STBTT_iceil(x) ((int)ceilf(x))
+#define STBTT_STATIC
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "imstb_truetype.h"
+
+namespace window {
+namespace font_builder {
+
+// Glyphs rasterised per task, small enough to balance a single large font
+// across every core.
+static const int glyphs_per_task = 32;
+
+struct source {
+    stbtt_fontinfo info;
+    const ImWchar* ranges;
+    int dst_index;
+    int glyphs_highest;
+    std::vector<int> glyphs;
+    std::vector<stbrp_rect> rects;
+    std::vector<stbtt_packedchar> packed_chars;
+    stbtt_pack_range pack_range;
+};
+
+struct destination {
+    int glyphs_highest;
+    std::vector<bool> glyphs_set;
+};
+
+struct task {
+    int source;
+    int first;
+    int count;
+};
+
+// Follows ImFontAtlasBuildWithStbTruetype() step by step, see imgui_draw.cpp
+static bool build(ImFontAtlas* atlas) {
+    IM_ASSERT(atlas->ConfigData.Size > 0);
+
+    ImFontAtlasBuildInit(atlas);
+
+    // Clear atlas
+    atlas->TexID = (ImTextureID)NULL;
+    atlas->TexWidth = atlas->TexHeight = 0;
+    atlas->TexUvScale = ImVec2(0.0f, 0.0f);
+    atlas->TexUvWhitePixel = ImVec2(0.0f, 0.0f);
+    atlas->ClearTexData();
+
+    std::vector<source> sources(atlas->ConfigData.Size);
+    std::vector<destination> destinations(atlas->Fonts.Size);
+
+    // 1. Initialize font loading structure, check font data validity
+    for (int src_i = 0; src_i < atlas->ConfigData.Size; src_i++) {
+        source& src = sources[src_i];
+        ImFontConfig& cfg = atlas->ConfigData[src_i];
+        IM_ASSERT(cfg.DstFont && (!cfg.DstFont->IsLoaded() ||
+                                  cfg.DstFont->ContainerAtlas == atlas));
+
+        src.dst_index = -1;
+        for (int dst_i = 0; dst_i < atlas->Fonts.Size; dst_i++) {
+            if (cfg.DstFont == atlas->Fonts[dst_i]) {
+                src.dst_index = dst_i;
+                break;
+            }
+        }
+        if (src.dst_index == -1) {
+            IM_ASSERT(src.dst_index != -1);
+            return false;
+        }
+        const unsigned char* data = (const unsigned char*)cfg.FontData;
+        int font_offset = stbtt_GetFontOffsetForIndex(data, cfg.FontNo);
+        IM_ASSERT(font_offset >= 0);
+        if (!stbtt_InitFont(&src.info, data, font_offset)) {
+            return false;
+        }
+
+        // Measure highest codepoints
+        destination& dst = destinations[src.dst_index];
+        src.ranges = cfg.GlyphRanges ? cfg.GlyphRanges
+                                     : atlas->GetGlyphRangesDefault();
+        src.glyphs_highest = 0;
+        for (const ImWchar* range = src.ranges; range[0] && range[1];
+             range += 2) {
+            src.glyphs_highest = ImMax(src.glyphs_highest, (int)range[1]);
+        }
+        dst.glyphs_highest = ImMax(dst.glyphs_highest, src.glyphs_highest);
+    }
+
+    // 2-3. For every requested codepoint, check for their presence in the
+    // font data, earlier sources win when several are merged into one font.
+    // The resulting list is sorted by codepoint like ImGui's bit vector.
+    for (source& src : sources) {
+        destination& dst = destinations[src.dst_index];
+        if (dst.glyphs_set.empty()) {
+            dst.glyphs_set.resize(dst.glyphs_highest + 1);
+        }
+        std::vector<bool> glyphs_set(src.glyphs_highest + 1);
+        for (const ImWchar* range = src.ranges; range[0] && range[1];
+             range += 2) {
+            for (unsigned int c = range[0]; c <= range[1]; c++) {
+                if (dst.glyphs_set[c] || !stbtt_FindGlyphIndex(&src.info, c)) {
+                    continue;
+                }
+                glyphs_set[c] = true;
+                dst.glyphs_set[c] = true;
+            }
+        }
+        for (int c = 0; c < (int)glyphs_set.size(); c++) {
+            if (glyphs_set[c]) {
+                src.glyphs.push_back(c);
+            }
+        }
+    }
+    destinations.clear();
+
+    // 4. Gather glyphs sizes so we can pack them in our virtual canvas
+    std::vector<int> surfaces(sources.size());
+    thread_pool::parallel_for((int)sources.size(), [&](int src_i) {
+        source& src = sources[src_i];
+        const ImFontConfig& cfg = atlas->ConfigData[src_i];
+        int count = (int)src.glyphs.size();
+        src.rects.assign(count, stbrp_rect());
+        src.packed_chars.assign(count, stbtt_packedchar());
+
+        src.pack_range.font_size = cfg.SizePixels;
+        src.pack_range.first_unicode_codepoint_in_range = 0;
+        src.pack_range.array_of_unicode_codepoints = src.glyphs.data();
+        src.pack_range.num_chars = count;
+        src.pack_range.chardata_for_range = src.packed_chars.data();
+        src.pack_range.h_oversample = (unsigned char)cfg.OversampleH;
+        src.pack_range.v_oversample = (unsigned char)cfg.OversampleV;
+
+        const float scale =
+            (cfg.SizePixels > 0)
+                ? stbtt_ScaleForPixelHeight(&src.info, cfg.SizePixels)
+                : stbtt_ScaleForMappingEmToPixels(&src.info,
+                                                  -cfg.SizePixels);
+        const int padding = atlas->TexGlyphPadding;
+        for (int glyph_i = 0; glyph_i < count; glyph_i++) {
+            int x0, y0, x1, y1;
+            int glyph = stbtt_FindGlyphIndex(&src.info, src.glyphs[glyph_i]);
+            IM_ASSERT(glyph != 0);
+            stbtt_GetGlyphBitmapBoxSubpixel(
+                &src.info, glyph, scale * cfg.OversampleH,
+                scale * cfg.OversampleV, 0, 0, &x0, &y0, &x1, &y1);
+            stbrp_rect& rect = src.rects[glyph_i];
+            rect.w = (stbrp_coord)(x1 - x0 + padding + cfg.OversampleH - 1);
+            rect.h = (stbrp_coord)(y1 - y0 + padding + cfg.OversampleV - 1);
+            surfaces[src_i] += rect.w * rect.h;
+        }
+    });
+    int total_surface = 0;
+    for (int surface : surfaces) {
+        total_surface += surface;
+    }
+
+    const int surface_sqrt = (int)ImSqrt((float)total_surface) + 1;
+    atlas->TexHeight = 0;
+    if (atlas->TexDesiredWidth > 0) {
+        atlas->TexWidth = atlas->TexDesiredWidth;
+    } else {
+        atlas->TexWidth = (surface_sqrt >= 4096 * 0.7f)   ? 4096
+                          : (surface_sqrt >= 2048 * 0.7f) ? 2048
+                          : (surface_sqrt >= 1024 * 0.7f) ? 1024
+                                                          : 512;
+    }
+
+    // 5. Start packing, custom rects go first to keep their UVs small
+    const int tex_height_max = 1024 * 32;
+    stbtt_pack_context spc = {};
+    stbtt_PackBegin(&spc, NULL, atlas->TexWidth, tex_height_max, 0,
+                    atlas->TexGlyphPadding, NULL);
+    ImFontAtlasBuildPackCustomRects(atlas, spc.pack_info);
+
+    // 6. Pack each source font, serially so the layout matches ImGui's
+    for (source& src : sources) {
+        if (src.glyphs.empty()) {
+            continue;
+        }
+        stbrp_pack_rects((stbrp_context*)spc.pack_info, src.rects.data(),
+                         (int)src.rects.size());
+        for (const stbrp_rect& rect : src.rects) {
+            if (rect.was_packed) {
+                atlas->TexHeight = ImMax(atlas->TexHeight, rect.y + rect.h);
+            }
+        }
+    }
+
+    // 7. Allocate texture
+    atlas->TexHeight = (atlas->Flags & ImFontAtlasFlags_NoPowerOfTwoHeight)
+                           ? (atlas->TexHeight + 1)
+                           : ImUpperPowerOfTwo(atlas->TexHeight);
+    atlas->TexUvScale =
+        ImVec2(1.0f / atlas->TexWidth, 1.0f / atlas->TexHeight);
+    atlas->TexPixelsAlpha8 =
+        (unsigned char*)IM_ALLOC(atlas->TexWidth * atlas->TexHeight);
+    memset(atlas->TexPixelsAlpha8, 0, atlas->TexWidth * atlas->TexHeight);
+    spc.pixels = atlas->TexPixelsAlpha8;
+    spc.height = atlas->TexHeight;
+
+    // 8. Render/rasterize font characters into the texture. Packed rects do
+    // not overlap, so tasks write to disjoint pixels.
+    std::vector<task> tasks;
+    for (int src_i = 0; src_i < (int)sources.size(); src_i++) {
+        int count = (int)sources[src_i].glyphs.size();
+        for (int first = 0; first < count; first += glyphs_per_task) {
+            tasks.push_back(
+                {src_i, first, ImMin(glyphs_per_task, count - first)});
+        }
+    }
+    thread_pool::parallel_for((int)tasks.size(), [&](int task_i) {
+        const task& t = tasks[task_i];
+        source& src = sources[t.source];
+        const ImFontConfig& cfg = atlas->ConfigData[t.source];
+
+        // stb_truetype saves and restores the oversampling settings in the
+        // pack context while rendering, so every task needs its own copy.
+        stbtt_pack_context task_spc = spc;
+        stbtt_pack_range range = src.pack_range;
+        range.array_of_unicode_codepoints = src.glyphs.data() + t.first;
+        range.num_chars = t.count;
+        range.chardata_for_range = src.packed_chars.data() + t.first;
+        stbrp_rect* rects = src.rects.data() + t.first;
+        stbtt_PackFontRangesRenderIntoRects(&task_spc, &src.info, &range, 1,
+                                            rects);
+
+        // Apply multiply operator
+        if (cfg.RasterizerMultiply != 1.0f) {
+            unsigned char multiply_table[256];
+            ImFontAtlasBuildMultiplyCalcLookupTable(multiply_table,
+                                                    cfg.RasterizerMultiply);
+            for (int glyph_i = 0; glyph_i < t.count; glyph_i++) {
+                const stbrp_rect& r = rects[glyph_i];
+                if (r.was_packed) {
+                    ImFontAtlasBuildMultiplyRectAlpha8(
+                        multiply_table, atlas->TexPixelsAlpha8, r.x, r.y, r.w,
+                        r.h, atlas->TexWidth * 1);
+                }
+            }
+        }
+    });
+
+    // End packing
+    stbtt_PackEnd(&spc);
+
+    // 9. Setup ImFont and glyphs for runtime
+    for (int src_i = 0; src_i < (int)sources.size(); src_i++) {
+        source& src = sources[src_i];
+        if (src.glyphs.empty()) {
+            continue;
+        }
+        ImFontConfig& cfg = atlas->ConfigData[src_i];
+        ImFont* dst_font = cfg.DstFont;
+
+        const float font_scale =
+            stbtt_ScaleForPixelHeight(&src.info, cfg.SizePixels);
+        int unscaled_ascent, unscaled_descent, unscaled_line_gap;
+        stbtt_GetFontVMetrics(&src.info, &unscaled_ascent, &unscaled_descent,
+                              &unscaled_line_gap);
+        const float ascent = ImFloor(unscaled_ascent * font_scale +
+                                     ((unscaled_ascent > 0.0f) ? +1 : -1));
+        const float descent = ImFloor(unscaled_descent * font_scale +
+                                      ((unscaled_descent > 0.0f) ? +1 : -1));
+        ImFontAtlasBuildSetupFont(atlas, dst_font, &cfg, ascent, descent);
+        const float font_off_x = cfg.GlyphOffset.x;
+        const float font_off_y = cfg.GlyphOffset.y + IM_ROUND(dst_font->Ascent);
+
+        for (int glyph_i = 0; glyph_i < (int)src.glyphs.size(); glyph_i++) {
+            const int codepoint = src.glyphs[glyph_i];
+            const stbtt_packedchar& pc = src.packed_chars[glyph_i];
+            stbtt_aligned_quad q;
+            float unused_x = 0.0f, unused_y = 0.0f;
+            stbtt_GetPackedQuad(src.packed_chars.data(), atlas->TexWidth,
+                                atlas->TexHeight, glyph_i, &unused_x,
+                                &unused_y, &q, 0);
+            dst_font->AddGlyph(&cfg, (ImWchar)codepoint, q.x0 + font_off_x,
+                               q.y0 + font_off_y, q.x1 + font_off_x,
+                               q.y1 + font_off_y, q.s0, q.t0, q.s1, q.t1,
+                               pc.xadvance);
+        }
+    }
+
+    ImFontAtlasBuildFinish(atlas);
+    return true;
+}
+
+const ImFontBuilderIO* parallel() {
+    static const ImFontBuilderIO io = {build};
+    return &io;
+}
+
+} // namespace font_builder
+} // namespace window
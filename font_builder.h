@@ -0,0 +1,18 @@
+#pragma once
+
+// Font atlas builder rasterising glyphs on the thread pool.
+//
+// Assign to ImFontAtlas::FontBuilderIO before building. Glyphs are gathered
+// and packed in the same order as ImGui's stb_truetype builder, only the
+// rasterisation into the packed rects runs in parallel, so the resulting
+// texture is bit-identical to a serial build.
+
+#include "imgui.h"
+
+namespace window {
+namespace font_builder {
+
+const ImFontBuilderIO* parallel();
+
+} // namespace font_builder
+} // namespace window
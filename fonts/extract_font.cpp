@@ -0,0 +1,42 @@
+// Writes one of the embedded fonts back out as a TTF file, so it can be
+// subset at build time (see subset_font.cmake).
+
+#include "FiraMono_Regular.h"
+#include "FiraSans_Regular.h"
+#include "imgui.h"
+#include <stdio.h>
+#include <string.h>
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <font> <output.ttf>\n", argv[0]);
+        return 1;
+    }
+
+    const unsigned int* data;
+    unsigned int size;
+    if (strcmp(argv[1], "FiraMono_Regular") == 0) {
+        data = FiraMono_Regular_compressed_data;
+        size = FiraMono_Regular_compressed_size;
+    } else if (strcmp(argv[1], "FiraSans_Regular") == 0) {
+        data = FiraSans_Regular_compressed_data;
+        size = FiraSans_Regular_compressed_size;
+    } else {
+        fprintf(stderr, "Error: unknown font '%s'\n", argv[1]);
+        return 1;
+    }
+
+    // Let the atlas decompress it, it keeps the TTF data in its config
+    ImFontAtlas atlas;
+    atlas.AddFontFromMemoryCompressedTTF(data, (int)size, 16.0f);
+    const ImFontConfig& config = atlas.ConfigData.back();
+
+    FILE* f = fopen(argv[2], "wb");
+    if (f == NULL) {
+        fprintf(stderr, "Error: could not open '%s'\n", argv[2]);
+        return 1;
+    }
+    size_t written = fwrite(config.FontData, 1, config.FontDataSize, f);
+    fclose(f);
+    return written == (size_t)config.FontDataSize ? 0 : 1;
+}
@@ -0,0 +1,36 @@
+# Subsets one of the embedded fonts and writes it back out as a compressed
+# C header, in the same format as the headers in this directory.
+#
+# Expects EXTRACT_FONT, PYFTSUBSET and BINARY_TO_COMPRESSED_C (tool paths),
+# FONT (symbol name), UNICODES (pyftsubset syntax, e.g. U+20-7E,U+2026-2026)
+# and OUTPUT_DIR.
+
+set(ttf "${OUTPUT_DIR}/${FONT}.ttf")
+set(subset_ttf "${OUTPUT_DIR}/${FONT}.subset.ttf")
+
+execute_process(
+    COMMAND "${EXTRACT_FONT}" "${FONT}" "${ttf}"
+    RESULT_VARIABLE result)
+if(result)
+    message(FATAL_ERROR "Could not extract ${FONT}")
+endif()
+
+# stb_truetype ignores hinting and layout tables, so drop them as well
+execute_process(
+    COMMAND "${PYFTSUBSET}" "${ttf}"
+        "--unicodes=${UNICODES}"
+        "--layout-features="
+        "--no-hinting"
+        "--output-file=${subset_ttf}"
+    RESULT_VARIABLE result)
+if(result)
+    message(FATAL_ERROR "Could not subset ${FONT}")
+endif()
+
+execute_process(
+    COMMAND "${BINARY_TO_COMPRESSED_C}" "${subset_ttf}" "${FONT}"
+    OUTPUT_FILE "${OUTPUT_DIR}/${FONT}.h"
+    RESULT_VARIABLE result)
+if(result)
+    message(FATAL_ERROR "Could not compress ${FONT}")
+endif()
@@ -0,0 +1,13 @@
+#pragma once
+
+// Included by imgui.h through IMGUI_USER_CONFIG.
+//
+// Font atlases are built on worker threads while the main thread runs ImGui
+// frames. ImGui::MemAlloc() counts allocations in the current context, so
+// each thread gets a context pointer of its own. It is only ever set on the
+// main thread, and stays null on workers, where allocations are then not
+// counted.
+
+struct ImGuiContext;
+extern thread_local ImGuiContext* imgui_boilerplate_context;
+#define GImGui imgui_boilerplate_context
@@ -0,0 +1,591 @@
+#include "opengl.h"
+
+#include "disk_cache.h"
+#include "imgui.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace window {
+namespace gl {
+
+static char glsl_version_string[32] = "#version 130";
+
+// Values not known to be current are -1 (NaN for the clear colour)
+static const GLint unknown = -1;
+
+enum capability { blend, cull_face, depth_test, stencil_test, scissor_test };
+static const GLenum capabilities[] = {GL_BLEND, GL_CULL_FACE, GL_DEPTH_TEST,
+                                      GL_STENCIL_TEST, GL_SCISSOR_TEST};
+
+struct shadow_state {
+    GLint program;
+    GLint active_texture;
+    GLint texture;
+    GLint sampler;
+    GLint array_buffer;
+    GLint element_array_buffer;
+    GLint vertex_array;
+    GLint enabled[IM_ARRAYSIZE(capabilities)];
+    GLint blend_equation_rgb, blend_equation_alpha;
+    GLint blend_src_rgb, blend_dst_rgb, blend_src_alpha, blend_dst_alpha;
+    GLint polygon_mode;
+    GLint viewport[4];
+    GLint scissor[4];
+    GLfloat clear_color[4];
+};
+
+static shadow_state unknown_state() {
+    shadow_state s;
+    GLint* values[] = {&s.program,
+                       &s.active_texture,
+                       &s.texture,
+                       &s.sampler,
+                       &s.array_buffer,
+                       &s.element_array_buffer,
+                       &s.vertex_array,
+                       &s.blend_equation_rgb,
+                       &s.blend_equation_alpha,
+                       &s.blend_src_rgb,
+                       &s.blend_dst_rgb,
+                       &s.blend_src_alpha,
+                       &s.blend_dst_alpha,
+                       &s.polygon_mode};
+    for (GLint* value : values) {
+        *value = unknown;
+    }
+    for (GLint& enabled : s.enabled) {
+        enabled = unknown;
+    }
+    for (int i = 0; i < 4; i++) {
+        s.viewport[i] = unknown;
+        s.scissor[i] = unknown;
+        s.clear_color[i] = NAN;
+    }
+    return s;
+}
+
+static shadow_state state = unknown_state();
+static const void* current_context;
+
+void init(const char* glsl_version) {
+    if (glsl_version != nullptr) {
+        snprintf(glsl_version_string, sizeof(glsl_version_string), "%s",
+                 glsl_version);
+    }
+}
+
+bool has_version(int major, int minor) {
+    // GL_MAJOR_VERSION is not available on OpenGL ES 2, parse the string
+    const char* version = (const char*)glGetString(GL_VERSION);
+    if (version == nullptr) {
+        return false;
+    }
+    if (strncmp(version, "OpenGL ES ", 10) == 0) {
+        version += 10;
+    }
+    int context_major = 0, context_minor = 0;
+    sscanf(version, "%d.%d", &context_major, &context_minor);
+    return context_major > major ||
+           (context_major == major && context_minor >= minor);
+}
+
+bool has_extension(const char* name) {
+#if defined(IMGUI_IMPL_OPENGL_ES2)
+    const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+    size_t length = strlen(name);
+    for (const char* s = extensions; s && (s = strstr(s, name)); s += length) {
+        if ((s == extensions || s[-1] == ' ') &&
+            (s[length] == ' ' || s[length] == '\0')) {
+            return true;
+        }
+    }
+#else
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if (extension && strcmp(extension, name) == 0) {
+            return true;
+        }
+    }
+#endif
+    return false;
+}
+
+static bool check_shader(GLuint handle, const char* desc,
+                         const char* stage) {
+    GLint status = 0;
+    glGetShaderiv(handle, GL_COMPILE_STATUS, &status);
+    if (status == GL_TRUE) {
+        return true;
+    }
+    char log[1024] = "";
+    glGetShaderInfoLog(handle, sizeof(log), nullptr, log);
+    fprintf(stderr, "Failed to compile %s %s shader: %s\n", desc, stage, log);
+    return false;
+}
+
+static GLuint compile_shader(GLenum type, const char* prelude,
+                             const char* header, const char* source,
+                             const char* desc, const char* stage) {
+    const char* sources[] = {glsl_version_string, "\n", prelude, header,
+                             source};
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 5, sources, nullptr);
+    glCompileShader(shader);
+    if (!check_shader(shader, desc, stage)) {
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+#if !defined(IMGUI_IMPL_OPENGL_ES2)
+// glGetProgramBinary() needs OpenGL 4.1, GL_ARB_get_program_binary or
+// OpenGL ES 3.0, and a driver offering at least one binary format
+static bool has_program_binary() {
+    static int supported = -1;
+    if (supported < 0) {
+#if defined(IMGUI_IMPL_OPENGL_ES3)
+        bool available = has_version(3, 0);
+#else
+        bool available = has_version(4, 1) ||
+                         has_extension("GL_ARB_get_program_binary");
+#endif
+        GLint formats = 0;
+        if (available) {
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        }
+        supported = formats > 0;
+    }
+    return supported != 0;
+}
+
+static void hash(uint64_t& h, const char* str) {
+    for (; *str; str++) {
+        h = (h ^ (unsigned char)*str) * 1099511628211ull;
+    }
+}
+
+// Binaries only load into the driver that made them, from the same sources.
+// A driver update changes the version string and replaces the file.
+static std::string program_key(const char* const* sources, int count) {
+    uint64_t h = 14695981039346656037ull;
+    for (int i = 0; i < count; i++) {
+        hash(h, sources[i]);
+        hash(h, "\n");
+    }
+    std::string key;
+    for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+        const char* str = (const char*)glGetString(name);
+        key += str != nullptr ? str : "";
+        key += '\n';
+    }
+    char source_hash[17];
+    snprintf(source_hash, sizeof(source_hash), "%016llx",
+             (unsigned long long)h);
+    return key + source_hash;
+}
+
+// Cache files hold the key, a NUL, the binary format and the binary
+static GLuint load_program(const char* file, const std::string& key) {
+    std::vector<char> data = disk_cache::read(file);
+    size_t header = key.size() + 1 + sizeof(uint32_t);
+    if (data.size() <= header ||
+        memcmp(data.data(), key.c_str(), key.size() + 1) != 0) {
+        return 0;
+    }
+    uint32_t format;
+    memcpy(&format, data.data() + key.size() + 1, sizeof(format));
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, (GLenum)format, data.data() + header,
+                    (GLsizei)(data.size() - header));
+    GLint status = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        // Rejected by the driver, compiled again and replaced
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+static void save_program(GLuint program, const char* file,
+                         const std::string& key) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+    size_t header = key.size() + 1 + sizeof(uint32_t);
+    std::vector<char> data(header + (size_t)length);
+    memcpy(data.data(), key.c_str(), key.size() + 1);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format,
+                       data.data() + header);
+    uint32_t format_value = format;
+    memcpy(data.data() + key.size() + 1, &format_value,
+           sizeof(format_value));
+    data.resize(header + (size_t)length);
+    disk_cache::write(file, data);
+}
+#endif
+
+GLuint create_program(const char* vertex_source, const char* fragment_source,
+                      const char* desc) {
+    int version = 130;
+    sscanf(glsl_version_string, "#version %d", &version);
+    bool is_es = version == 100 || strstr(glsl_version_string, " es");
+
+    const char* prelude = "";
+    if (version == 100) {
+        prelude = "#extension GL_OES_standard_derivatives : enable\n"
+                  "precision mediump float;\n";
+    } else if (is_es) {
+        prelude = "precision mediump float;\n";
+    }
+    const char* vertex_header;
+    const char* fragment_header;
+    if (version < 130) {
+        vertex_header = "#define IN attribute\n#define OUT varying\n";
+        fragment_header = "#define IN varying\n#define texture texture2D\n"
+                          "#define OUT_COLOR gl_FragColor\n";
+    } else {
+        vertex_header = "#define IN in\n#define OUT out\n";
+        fragment_header = "#define IN in\nout vec4 Out_Color;\n"
+                          "#define OUT_COLOR Out_Color\n";
+    }
+
+#if !defined(IMGUI_IMPL_OPENGL_ES2)
+    // Linked programs are kept on disk, compiling takes a noticeable part
+    // of startup on software drivers or with a cold driver cache
+    bool cache = has_program_binary();
+    std::string file = std::string("gl_program_") + desc;
+    std::string key;
+    if (cache) {
+        const char* sources[] = {glsl_version_string, prelude,
+                                 vertex_header,       vertex_source,
+                                 fragment_header,     fragment_source};
+        key = program_key(sources, IM_ARRAYSIZE(sources));
+        if (GLuint program = load_program(file.c_str(), key)) {
+            return program;
+        }
+    }
+#endif
+
+    GLuint vertex = compile_shader(GL_VERTEX_SHADER, prelude, vertex_header,
+                                   vertex_source, desc, "vertex");
+    GLuint fragment =
+        compile_shader(GL_FRAGMENT_SHADER, prelude, fragment_header,
+                       fragment_source, desc, "fragment");
+    if (vertex == 0 || fragment == 0) {
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    glBindAttribLocation(program, 0, "Position");
+    glBindAttribLocation(program, 1, "UV");
+    glBindAttribLocation(program, 2, "Color");
+#if !defined(IMGUI_IMPL_OPENGL_ES2)
+    if (cache) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                            GL_TRUE);
+    }
+#endif
+    glLinkProgram(program);
+    glDetachShader(program, vertex);
+    glDetachShader(program, fragment);
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+
+    GLint status = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        char log[1024] = "";
+        glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+        fprintf(stderr, "Failed to link %s program: %s\n", desc, log);
+        glDeleteProgram(program);
+        return 0;
+    }
+#if !defined(IMGUI_IMPL_OPENGL_ES2)
+    if (cache) {
+        save_program(program, file.c_str(), key);
+    }
+#endif
+    return program;
+}
+
+void invalidate() { state = unknown_state(); }
+
+void make_current(const void* context) {
+    if (context != current_context) {
+        current_context = context;
+        invalidate();
+    }
+}
+
+void use_program(GLuint program) {
+    if (state.program != (GLint)program) {
+        state.program = (GLint)program;
+        glUseProgram(program);
+    }
+}
+
+GLuint current_program() {
+    if (state.program == unknown) {
+        glGetIntegerv(GL_CURRENT_PROGRAM, &state.program);
+    }
+    return (GLuint)state.program;
+}
+
+void active_texture(GLenum unit) {
+    if (state.active_texture != (GLint)unit) {
+        state.active_texture = (GLint)unit;
+        glActiveTexture(unit);
+    }
+}
+
+void bind_texture(GLuint texture) {
+    active_texture(GL_TEXTURE0);
+    if (state.texture != (GLint)texture) {
+        state.texture = (GLint)texture;
+        glBindTexture(GL_TEXTURE_2D, texture);
+    }
+}
+
+void bind_sampler(GLuint sampler) {
+#if defined(GL_SAMPLER_BINDING)
+    if (state.sampler != (GLint)sampler) {
+        state.sampler = (GLint)sampler;
+        glBindSampler(0, sampler);
+    }
+#else
+    (void)sampler;
+#endif
+}
+
+void bind_buffer(GLenum target, GLuint buffer) {
+    GLint& bound = target == GL_ELEMENT_ARRAY_BUFFER
+                       ? state.element_array_buffer
+                       : state.array_buffer;
+    if (bound != (GLint)buffer) {
+        bound = (GLint)buffer;
+        glBindBuffer(target, buffer);
+    }
+}
+
+void bind_vertex_array(GLuint vertex_array) {
+#if !defined(IMGUI_IMPL_OPENGL_ES2)
+    if (state.vertex_array != (GLint)vertex_array) {
+        state.vertex_array = (GLint)vertex_array;
+        // The element array binding is part of the vertex array
+        state.element_array_buffer = unknown;
+        glBindVertexArray(vertex_array);
+    }
+#else
+    (void)vertex_array;
+#endif
+}
+
+void set_enabled(GLenum cap, bool enabled) {
+    for (int i = 0; i < IM_ARRAYSIZE(capabilities); i++) {
+        if (capabilities[i] != cap) {
+            continue;
+        }
+        if (state.enabled[i] == (GLint)enabled) {
+            return;
+        }
+        state.enabled[i] = (GLint)enabled;
+        break;
+    }
+    if (enabled) {
+        glEnable(cap);
+    } else {
+        glDisable(cap);
+    }
+}
+
+void blend_equation(GLenum rgb, GLenum alpha) {
+    if (state.blend_equation_rgb != (GLint)rgb ||
+        state.blend_equation_alpha != (GLint)alpha) {
+        state.blend_equation_rgb = (GLint)rgb;
+        state.blend_equation_alpha = (GLint)alpha;
+        glBlendEquationSeparate(rgb, alpha);
+    }
+}
+
+void blend_func(GLenum src_rgb, GLenum dst_rgb, GLenum src_alpha,
+                GLenum dst_alpha) {
+    if (state.blend_src_rgb != (GLint)src_rgb ||
+        state.blend_dst_rgb != (GLint)dst_rgb ||
+        state.blend_src_alpha != (GLint)src_alpha ||
+        state.blend_dst_alpha != (GLint)dst_alpha) {
+        state.blend_src_rgb = (GLint)src_rgb;
+        state.blend_dst_rgb = (GLint)dst_rgb;
+        state.blend_src_alpha = (GLint)src_alpha;
+        state.blend_dst_alpha = (GLint)dst_alpha;
+        glBlendFuncSeparate(src_rgb, dst_rgb, src_alpha, dst_alpha);
+    }
+}
+
+void polygon_mode(GLenum mode) {
+#if defined(GL_POLYGON_MODE)
+    if (state.polygon_mode != (GLint)mode) {
+        state.polygon_mode = (GLint)mode;
+        glPolygonMode(GL_FRONT_AND_BACK, mode);
+    }
+#else
+    (void)mode;
+#endif
+}
+
+static bool set_rect(GLint* rect, GLint x, GLint y, GLsizei width,
+                     GLsizei height) {
+    if (rect[0] == x && rect[1] == y && rect[2] == width &&
+        rect[3] == height) {
+        return false;
+    }
+    rect[0] = x;
+    rect[1] = y;
+    rect[2] = width;
+    rect[3] = height;
+    return true;
+}
+
+void viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    if (set_rect(state.viewport, x, y, width, height)) {
+        glViewport(x, y, width, height);
+    }
+}
+
+void scissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+    if (set_rect(state.scissor, x, y, width, height)) {
+        glScissor(x, y, width, height);
+    }
+}
+
+void clear_color(GLfloat r, GLfloat g, GLfloat b, GLfloat a) {
+    GLfloat* color = state.clear_color;
+    if (color[0] != r || color[1] != g || color[2] != b || color[3] != a) {
+        color[0] = r;
+        color[1] = g;
+        color[2] = b;
+        color[3] = a;
+        glClearColor(r, g, b, a);
+    }
+}
+
+void deleted_buffer(GLuint buffer) {
+    if (state.array_buffer == (GLint)buffer) {
+        state.array_buffer = 0;
+    }
+    if (state.element_array_buffer == (GLint)buffer) {
+        state.element_array_buffer = 0;
+    }
+}
+
+void deleted_texture(GLuint texture) {
+    if (state.texture == (GLint)texture) {
+        state.texture = 0;
+    }
+}
+
+#if defined(IMGUI_BOILERPLATE_GL_STATE_VALIDATION)
+static int check(const char* where, const char* name, GLenum pname,
+                 const GLint* cached, int count) {
+    GLint actual[4] = {};
+    glGetIntegerv(pname, actual);
+    int mismatches = 0;
+    for (int i = 0; i < count; i++) {
+        if (cached[i] != unknown && cached[i] != actual[i]) {
+            fprintf(stderr, "GL state cache mismatch %s: %s[%d] is %d, "
+                            "cached %d\n",
+                    where, name, i, actual[i], cached[i]);
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+#endif
+
+void validate(const char* where) {
+#if defined(IMGUI_BOILERPLATE_GL_STATE_VALIDATION)
+    int mismatches = 0;
+    mismatches += check(where, "GL_CURRENT_PROGRAM", GL_CURRENT_PROGRAM,
+                        &state.program, 1);
+    mismatches += check(where, "GL_ACTIVE_TEXTURE", GL_ACTIVE_TEXTURE,
+                        &state.active_texture, 1);
+    if (state.active_texture == GL_TEXTURE0) {
+        mismatches += check(where, "GL_TEXTURE_BINDING_2D",
+                            GL_TEXTURE_BINDING_2D, &state.texture, 1);
+    }
+#if defined(GL_SAMPLER_BINDING)
+    if (state.active_texture == GL_TEXTURE0) {
+        mismatches += check(where, "GL_SAMPLER_BINDING", GL_SAMPLER_BINDING,
+                            &state.sampler, 1);
+    }
+#endif
+    mismatches += check(where, "GL_ARRAY_BUFFER_BINDING",
+                        GL_ARRAY_BUFFER_BINDING, &state.array_buffer, 1);
+    mismatches += check(where, "GL_ELEMENT_ARRAY_BUFFER_BINDING",
+                        GL_ELEMENT_ARRAY_BUFFER_BINDING,
+                        &state.element_array_buffer, 1);
+#if !defined(IMGUI_IMPL_OPENGL_ES2)
+    mismatches += check(where, "GL_VERTEX_ARRAY_BINDING",
+                        GL_VERTEX_ARRAY_BINDING, &state.vertex_array, 1);
+#endif
+    for (int i = 0; i < IM_ARRAYSIZE(capabilities); i++) {
+        if (state.enabled[i] != unknown &&
+            state.enabled[i] != (GLint)glIsEnabled(capabilities[i])) {
+            fprintf(stderr, "GL state cache mismatch %s: capability 0x%x\n",
+                    where, capabilities[i]);
+            mismatches++;
+        }
+    }
+    mismatches += check(where, "GL_BLEND_EQUATION_RGB", GL_BLEND_EQUATION_RGB,
+                        &state.blend_equation_rgb, 1);
+    mismatches += check(where, "GL_BLEND_EQUATION_ALPHA",
+                        GL_BLEND_EQUATION_ALPHA, &state.blend_equation_alpha,
+                        1);
+    mismatches += check(where, "GL_BLEND_SRC_RGB", GL_BLEND_SRC_RGB,
+                        &state.blend_src_rgb, 1);
+    mismatches += check(where, "GL_BLEND_DST_RGB", GL_BLEND_DST_RGB,
+                        &state.blend_dst_rgb, 1);
+    mismatches += check(where, "GL_BLEND_SRC_ALPHA", GL_BLEND_SRC_ALPHA,
+                        &state.blend_src_alpha, 1);
+    mismatches += check(where, "GL_BLEND_DST_ALPHA", GL_BLEND_DST_ALPHA,
+                        &state.blend_dst_alpha, 1);
+#if defined(GL_POLYGON_MODE)
+    mismatches += check(where, "GL_POLYGON_MODE", GL_POLYGON_MODE,
+                        &state.polygon_mode, 1);
+#endif
+    mismatches +=
+        check(where, "GL_VIEWPORT", GL_VIEWPORT, state.viewport, 4);
+    mismatches +=
+        check(where, "GL_SCISSOR_BOX", GL_SCISSOR_BOX, state.scissor, 4);
+    GLfloat color[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, color);
+    for (int i = 0; i < 4; i++) {
+        if (!isnan(state.clear_color[i]) && state.clear_color[i] != color[i]) {
+            fprintf(stderr, "GL state cache mismatch %s: clear colour\n",
+                    where);
+            mismatches++;
+            break;
+        }
+    }
+    IM_ASSERT(mismatches == 0 && "GL state changed behind the state cache");
+#else
+    (void)where;
+#endif
+}
+
+} // namespace gl
+} // namespace window
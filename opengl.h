@@ -0,0 +1,98 @@
+#pragma once
+
+// OpenGL headers matching the loader selected by imgui_impl_opengl3.h
+
+#include "imgui_impl_opengl3.h"
+
+#if defined(IMGUI_IMPL_OPENGL_ES2)
+#include <GLES2/gl2.h>
+// About Desktop OpenGL function loaders:
+//  Modern desktop OpenGL doesn't have a standard portable header file to load
+//  OpenGL function pointers.
+//  Helper libraries are often used for this purpose! Here we are supporting a
+//  few common ones (gl3w, glew, glad).
+//  You may use another loader/header of your choice (glext, glLoadGen, etc.),
+//  or chose to manually implement your own.
+#elif defined(IMGUI_IMPL_OPENGL_LOADER_GL3W)
+// Initialize with gl3wInit()
+#include <GL/gl3w.h>
+#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLEW)
+// Initialize with glewInit()
+#include <GL/glew.h>
+#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLAD)
+// Initialize with gladLoadGL()
+#include <glad/glad.h>
+#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLAD2)
+// Initialize with gladLoadGL(...) or gladLoaderLoadGL()
+#include <glad/gl.h>
+#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLBINDING2)
+// GLFW including OpenGL headers causes ambiguity or multiple definition errors.
+#define GLFW_INCLUDE_NONE
+// Initialize with glbinding::Binding::initialize()
+#include <glbinding/Binding.h>
+#include <glbinding/gl/gl.h>
+using namespace gl;
+#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLBINDING3)
+// GLFW including OpenGL headers causes ambiguity or multiple definition errors.
+#define GLFW_INCLUDE_NONE
+// Initialize with glbinding::initialize()
+#include <glbinding/gl/gl.h>
+#include <glbinding/glbinding.h>
+using namespace gl;
+#else
+#include IMGUI_IMPL_OPENGL_LOADER_CUSTOM
+#endif
+
+namespace window {
+namespace gl {
+
+// Use the GLSL version given to renderer::init() for create_program()
+void init(const char* glsl_version);
+
+// Version of the current context, desktop or ES depending on the build
+bool has_version(int major, int minor);
+bool has_extension(const char* name);
+
+// Compile and link a program, the sources are written against the IN, OUT,
+// OUT_COLOR and texture() macros so they work with every GLSL version.
+// Position, UV and Color are bound to attribute locations 0, 1 and 2.
+// Linked programs are cached on disk where the driver supports program
+// binaries, later runs load them instead of compiling. Returns 0 and prints
+// the log on failure.
+GLuint create_program(const char* vertex_source, const char* fragment_source,
+                      const char* desc);
+
+// Shadow copy of the context state set by the boilerplate, calls that would
+// not change anything are skipped. Code changing this state directly must
+// call invalidate() afterwards, every value is then set again on next use.
+void invalidate();
+// Each platform window has its own context, switching invalidates the copy
+void make_current(const void* context);
+
+void use_program(GLuint program);
+GLuint current_program();
+void active_texture(GLenum unit);
+// GL_TEXTURE_2D of texture unit 0
+void bind_texture(GLuint texture);
+void bind_sampler(GLuint sampler);
+void bind_buffer(GLenum target, GLuint buffer);
+void bind_vertex_array(GLuint vertex_array);
+void set_enabled(GLenum cap, bool enabled);
+void blend_equation(GLenum rgb, GLenum alpha);
+void blend_func(GLenum src_rgb, GLenum dst_rgb, GLenum src_alpha,
+                GLenum dst_alpha);
+void polygon_mode(GLenum mode);
+void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+void scissor(GLint x, GLint y, GLsizei width, GLsizei height);
+void clear_color(GLfloat r, GLfloat g, GLfloat b, GLfloat a);
+
+// Deleting a bound object resets its binding
+void deleted_buffer(GLuint buffer);
+void deleted_texture(GLuint texture);
+
+// With IMGUI_BOILERPLATE_GL_STATE_VALIDATION, compare the shadow copy with
+// glGet*() and report every mismatch. Does nothing otherwise.
+void validate(const char* where);
+
+} // namespace gl
+} // namespace window
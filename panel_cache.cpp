@@ -0,0 +1,291 @@
+#include "panel_cache.h"
+
+#include "capture.h"
+#include "damage.h"
+#include "imgui.h"
+#include "opengl.h"
+#include "renderer.h"
+#include "window.h"
+#include <SDL.h>
+#include <algorithm>
+#include <stdint.h>
+#include <stdio.h>
+#include <unordered_map>
+#include <vector>
+
+namespace window {
+namespace panel_cache {
+
+struct panel {
+    GLuint texture;
+    GLuint framebuffer;
+    int width;
+    int height;
+    uint64_t version;
+    ImFontAtlas* fonts;
+    int last_frame;
+    // Screen position the commands were captured at
+    ImVec2 pos;
+    // Of the viewport the panel was captured in
+    ImVec2 scale;
+    // Captured commands, kept until render()
+    ImDrawList* draw_list;
+};
+
+static std::unordered_map<ImGuiID, panel> panels;
+static std::vector<panel*> pending;
+static size_t budget = 64 << 20;
+// Panels not drawn for this many frames are dropped, texture and all
+static const int unused_frames = 300;
+static size_t used;
+static bool enabled;
+
+static size_t texture_size(const panel& p) {
+    return (size_t)p.width * (size_t)p.height * 4;
+}
+
+static void release(panel& p) {
+    if (p.texture == 0) {
+        return;
+    }
+    used -= texture_size(p);
+    glDeleteFramebuffers(1, &p.framebuffer);
+    glDeleteTextures(1, &p.texture);
+    gl::deleted_texture(p.texture);
+    p.texture = 0;
+    p.framebuffer = 0;
+}
+
+// Evict panels not drawn this frame until size bytes fit in the budget
+static bool make_room(size_t size) {
+    int frame = ImGui::GetFrameCount();
+    while (used + size > budget) {
+        panel* oldest = nullptr;
+        for (auto& entry : panels) {
+            panel& p = entry.second;
+            if (p.texture != 0 && p.last_frame < frame &&
+                (oldest == nullptr || p.last_frame < oldest->last_frame)) {
+                oldest = &p;
+            }
+        }
+        if (oldest == nullptr) {
+            return false;
+        }
+        release(*oldest);
+    }
+    return true;
+}
+
+static bool allocate(panel& p, int width, int height) {
+    release(p);
+    p.width = width;
+    p.height = height;
+    if (!make_room(texture_size(p))) {
+        return false;
+    }
+    used += texture_size(p);
+
+    glGenTextures(1, &p.texture);
+    gl::bind_texture(p.texture);
+    // Drawn at its pixel size, so there is nothing to filter
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, nullptr);
+
+    glGenFramebuffers(1, &p.framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, p.framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                           GL_TEXTURE_2D, p.texture, 0);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        fprintf(stderr, "Panel framebuffer incomplete: 0x%x\n", status);
+        release(p);
+        return false;
+    }
+    return true;
+}
+
+void init() { enabled = true; }
+
+// Content is drawn onto a transparent texture with imgui's usual blending,
+// which leaves premultiplied colours, so the texture is composited with
+// premultiplied blending
+static void use_premultiplied_blending(const ImDrawList*, const ImDrawCmd*) {
+    gl::blend_func(GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ONE,
+                   GL_ONE_MINUS_SRC_ALPHA);
+}
+
+// The SDL backend sets io.DisplayFramebufferScale from the main window only,
+// a platform window may be on a display of another density
+static ImVec2 framebuffer_scale(ImGuiViewport* viewport) {
+    SDL_Window* sdl_window = (SDL_Window*)viewport->PlatformHandle;
+    if (sdl_window == nullptr) {
+        return ImGui::GetIO().DisplayFramebufferScale;
+    }
+    int width, height, drawable_width, drawable_height;
+    SDL_GetWindowSize(sdl_window, &width, &height);
+    SDL_GL_GetDrawableSize(sdl_window, &drawable_width, &drawable_height);
+    if (width <= 0 || height <= 0) {
+        return ImGui::GetIO().DisplayFramebufferScale;
+    }
+    return ImVec2((float)drawable_width / width,
+                  (float)drawable_height / height);
+}
+
+// Commands fn added are only clipped to the panel. Left in the window's
+// draw list, they are clipped to the window's current clip rect as well,
+// like content drawn directly.
+static void clip_to_window(ImDrawList* draw_list, const capture::mark& m) {
+    ImVec2 min = draw_list->GetClipRectMin();
+    ImVec2 max = draw_list->GetClipRectMax();
+    // The last command before fn only holds its indices when it was empty
+    int first = m.command_count - 1;
+    if (m.last[1].ElemCount > 0) {
+        first = m.command_count;
+    }
+    for (int i = first; i < draw_list->CmdBuffer.Size; i++) {
+        ImVec4& r = draw_list->CmdBuffer[i].ClipRect;
+        r.x = std::max(r.x, min.x);
+        r.y = std::max(r.y, min.y);
+        r.z = std::min(r.z, max.x);
+        r.w = std::min(r.w, max.y);
+    }
+}
+
+static void drop_unused() {
+    int frame = ImGui::GetFrameCount();
+    for (auto it = panels.begin(); it != panels.end();) {
+        panel& p = it->second;
+        if (frame - p.last_frame > unused_frames) {
+            release(p);
+            IM_DELETE(p.draw_list);
+            it = panels.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void render() {
+    for (panel* p : pending) {
+        ImDrawList* draw_list = p->draw_list;
+        ImDrawData draw_data = ImDrawData();
+        draw_data.Valid = true;
+        draw_data.CmdLists = &draw_list;
+        draw_data.CmdListsCount = 1;
+        draw_data.TotalVtxCount = draw_list->VtxBuffer.Size;
+        draw_data.TotalIdxCount = draw_list->IdxBuffer.Size;
+        draw_data.DisplayPos = p->pos;
+        draw_data.FramebufferScale = p->scale;
+        draw_data.DisplaySize =
+            ImVec2(p->width / draw_data.FramebufferScale.x,
+                   p->height / draw_data.FramebufferScale.y);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, p->framebuffer);
+        gl::viewport(0, 0, p->width, p->height);
+        gl::set_enabled(GL_SCISSOR_TEST, false);
+        gl::clear_color(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        renderer::render(&draw_data);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        draw_list->VtxBuffer.clear();
+        draw_list->IdxBuffer.clear();
+        draw_list->CmdBuffer.clear();
+    }
+    pending.clear();
+    drop_unused();
+}
+
+void shutdown() {
+    for (auto& entry : panels) {
+        release(entry.second);
+        IM_DELETE(entry.second.draw_list);
+    }
+    panels.clear();
+    pending.clear();
+    enabled = false;
+}
+
+} // namespace panel_cache
+
+void set_panel_cache_budget(size_t bytes) { panel_cache::budget = bytes; }
+
+void cached_panel(const char* id, float width, float height,
+                  uint64_t version, const std::function<void()>& fn) {
+    using namespace panel_cache;
+    ImGuiIO& io = ImGui::GetIO();
+    ImVec2 pos = ImGui::GetCursorScreenPos();
+    ImVec2 size(width, height);
+    ImVec2 max(pos.x + width, pos.y + height);
+    ImVec2 scale = framebuffer_scale(ImGui::GetWindowViewport());
+    int pixel_width = (int)(width * scale.x);
+    int pixel_height = (int)(height * scale.y);
+
+    panel& p = panels[ImGui::GetID(id)];
+    p.last_frame = ImGui::GetFrameCount();
+    bool resized = p.texture == 0 || p.width != pixel_width ||
+                   p.height != pixel_height;
+    bool cached = enabled && pixel_width > 0 && pixel_height > 0 &&
+                  (!resized || allocate(p, pixel_width, pixel_height));
+    if (!cached) {
+        // Over budget, draw it like any other content
+        ImGui::PushClipRect(pos, max, true);
+        fn();
+        ImGui::PopClipRect();
+        ImGui::SetCursorScreenPos(pos);
+        ImGui::Dummy(size);
+        return;
+    }
+    bool stale = resized || p.version != version || p.fonts != io.Fonts ||
+                 p.scale.x != scale.x || p.scale.y != scale.y;
+
+    ImDrawList* window_draw_list = ImGui::GetWindowDrawList();
+    if (stale) {
+        // Clipped to the panel only, so the parts scrolled out of view are
+        // in the texture too
+        capture::mark mark = capture::begin(window_draw_list);
+        ImGui::PushClipRect(pos, max, false);
+        fn();
+        ImGui::PopClipRect();
+        capture::commands commands;
+        bool captured = capture::end(window_draw_list, mark, commands);
+        if (captured) {
+            capture::discard(window_draw_list, mark);
+            if (p.draw_list == nullptr) {
+                p.draw_list =
+                    IM_NEW(ImDrawList)(ImGui::GetDrawListSharedData());
+            }
+            p.draw_list->VtxBuffer.swap(commands.vertices);
+            p.draw_list->IdxBuffer.swap(commands.indices);
+            p.draw_list->CmdBuffer.swap(commands.commands);
+            p.version = version;
+            p.fonts = io.Fonts;
+            p.pos = pos;
+            p.scale = scale;
+            pending.push_back(&p);
+            damage::add(ImVec4(pos.x, pos.y, max.x, max.y));
+        } else {
+            // Left drawn directly, captured again next frame
+            clip_to_window(window_draw_list, mark);
+            p.fonts = nullptr;
+            ImGui::SetCursorScreenPos(pos);
+            ImGui::Dummy(size);
+            return;
+        }
+    }
+
+    // Rendered upside down, framebuffers have a bottom left origin
+    window_draw_list->AddCallback(use_premultiplied_blending, nullptr);
+    window_draw_list->AddImage((ImTextureID)(intptr_t)p.texture, pos, max,
+                               ImVec2(0.0f, 1.0f), ImVec2(1.0f, 0.0f));
+    window_draw_list->AddCallback(ImDrawCallback_ResetRenderState, nullptr);
+    ImGui::SetCursorScreenPos(pos);
+    ImGui::Dummy(size);
+}
+
+} // namespace window
@@ -0,0 +1,25 @@
+#pragma once
+
+// Textures behind window::cached_panel().
+//
+// A panel's draw commands are captured from the window's draw list and
+// rendered into a framebuffer object of the panel's size in pixels. The
+// window then draws the texture as a single quad, until the panel's version,
+// size or fonts change. Textures are evicted least recently used first to
+// stay within the budget, a panel that does not fit is drawn directly.
+// Panels are transparent where fn draws nothing, and forgotten after some
+// frames without being drawn.
+
+namespace window {
+namespace panel_cache {
+
+// With the OpenGL renderer. Panels are drawn directly without it.
+void init();
+
+// Render the panels captured this frame into their textures. After
+// ImGui::Render() and before the draw data is rendered.
+void render();
+void shutdown();
+
+} // namespace panel_cache
+} // namespace window
@@ -0,0 +1,764 @@
+#include "renderer.h"
+
+#include "imgui.h"
+#include "opengl.h"
+#include <SDL.h>
+#include <algorithm>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// Vertex arrays and glMapBufferRange() need OpenGL 3.0 or OpenGL ES 3.0,
+// persistent mapping and base vertex draws are only used on desktop OpenGL.
+#if !defined(IMGUI_IMPL_OPENGL_ES2)
+#define RENDERER_HAS_VERTEX_ARRAY
+#define RENDERER_HAS_MAP_BUFFER_RANGE
+#define RENDERER_HAS_SYNC
+#if !defined(IMGUI_IMPL_OPENGL_ES3)
+#define RENDERER_HAS_BUFFER_STORAGE
+#define RENDERER_HAS_BASE_VERTEX
+#endif
+#endif
+
+namespace window {
+namespace renderer {
+
+enum class stream_mode { buffer_storage, map_buffer_range, buffer_data };
+
+// Vertices and indices of a frame share one buffer, indices follow the
+// vertices. sizeof(ImDrawVert) keeps the index data aligned.
+struct stream_buffer {
+    GLuint buffer;
+    size_t capacity;
+    // Persistent mapping in stream_mode::buffer_storage
+    char* mapped;
+#if defined(RENDERER_HAS_BUFFER_STORAGE)
+    // Signalled when the GPU is done with the last frame drawn from it
+    GLsync fence;
+#endif
+};
+
+static const size_t min_capacity = 1 << 20;
+// A buffer is added to the ring instead of waiting while the GPU still
+// reads from the next one, up to this many.
+static const size_t max_buffers = 8;
+
+static stream_mode mode;
+static std::vector<stream_buffer> buffers;
+static size_t next_buffer;
+
+#if defined(RENDERER_HAS_SYNC)
+// Fences after each swap, oldest first, see set_max_frames_in_flight()
+struct frame_fence {
+    GLsync fence;
+    uint64_t input_time;
+};
+static std::vector<frame_fence> frame_fences;
+static bool has_sync;
+#endif
+static int max_frames_in_flight;
+
+static GLuint program;
+static GLint program_proj_mtx;
+static GLint program_texture;
+static bool has_samplers;
+static bool has_base_vertex;
+
+// Consecutive commands of a draw list sharing texture and clip rect, drawn
+// with a single call
+struct batch {
+    GLuint texture;
+    ImVec4 clip_rect;
+    size_t first_vertex;
+    size_t first_index;
+    unsigned int count;
+};
+
+// Vertex the attribute pointers start at, without base vertex draws
+static size_t bound_vertex;
+static frame_stats stats;
+static bool preserve_state;
+static float projection[4][4];
+// Framebuffer rectangles render() is limited to, null for all of it
+static const ImVector<ImVec4>* regions;
+
+// Where a draw data's lists start in a stream buffer, vertices are counted
+// from the start of the buffer and indices from index_offset
+struct placement {
+    ImDrawData* draw_data;
+    GLuint buffer;
+    size_t first_vertex;
+    size_t index_offset;
+};
+// Uploaded by upload_viewports() for render() to draw this frame
+static std::vector<placement> placements;
+
+// Vertex arrays are not shared between contexts. This one is used with the
+// context current at init(), platform windows with a context of their own
+// get one per render() like the OpenGL3 backend does.
+static SDL_GLContext main_context;
+static GLuint main_vertex_array;
+
+// State changed by render(), restored once the frame is drawn if other code
+// renders with the same context, see window::preserve_gl_state()
+struct saved_state {
+    GLenum active_texture;
+    GLint program;
+    GLint texture;
+    GLint sampler;
+    GLint array_buffer;
+    GLint element_array_buffer;
+    GLint vertex_array;
+    GLint polygon_mode[2];
+    GLint viewport[4];
+    GLint scissor_box[4];
+    GLint blend_src_rgb, blend_dst_rgb, blend_src_alpha, blend_dst_alpha;
+    GLint blend_equation_rgb, blend_equation_alpha;
+    GLboolean blend, cull_face, depth_test, stencil_test, scissor_test;
+};
+
+static void save_state(saved_state& s) {
+    glGetIntegerv(GL_ACTIVE_TEXTURE, (GLint*)&s.active_texture);
+    glActiveTexture(GL_TEXTURE0);
+    glGetIntegerv(GL_CURRENT_PROGRAM, &s.program);
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &s.texture);
+#if defined(GL_SAMPLER_BINDING)
+    if (has_samplers) {
+        glGetIntegerv(GL_SAMPLER_BINDING, &s.sampler);
+    }
+#endif
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &s.array_buffer);
+    glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &s.element_array_buffer);
+#if defined(RENDERER_HAS_VERTEX_ARRAY)
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &s.vertex_array);
+#endif
+#if defined(GL_POLYGON_MODE)
+    glGetIntegerv(GL_POLYGON_MODE, s.polygon_mode);
+#endif
+    glGetIntegerv(GL_VIEWPORT, s.viewport);
+    glGetIntegerv(GL_SCISSOR_BOX, s.scissor_box);
+    glGetIntegerv(GL_BLEND_SRC_RGB, &s.blend_src_rgb);
+    glGetIntegerv(GL_BLEND_DST_RGB, &s.blend_dst_rgb);
+    glGetIntegerv(GL_BLEND_SRC_ALPHA, &s.blend_src_alpha);
+    glGetIntegerv(GL_BLEND_DST_ALPHA, &s.blend_dst_alpha);
+    glGetIntegerv(GL_BLEND_EQUATION_RGB, &s.blend_equation_rgb);
+    glGetIntegerv(GL_BLEND_EQUATION_ALPHA, &s.blend_equation_alpha);
+    s.blend = glIsEnabled(GL_BLEND);
+    s.cull_face = glIsEnabled(GL_CULL_FACE);
+    s.depth_test = glIsEnabled(GL_DEPTH_TEST);
+    s.stencil_test = glIsEnabled(GL_STENCIL_TEST);
+    s.scissor_test = glIsEnabled(GL_SCISSOR_TEST);
+}
+
+static void restore_state(const saved_state& s) {
+    gl::use_program((GLuint)s.program);
+    gl::bind_texture((GLuint)s.texture);
+    if (has_samplers) {
+        gl::bind_sampler((GLuint)s.sampler);
+    }
+    gl::active_texture(s.active_texture);
+#if defined(RENDERER_HAS_VERTEX_ARRAY)
+    gl::bind_vertex_array((GLuint)s.vertex_array);
+#else
+    gl::bind_buffer(GL_ELEMENT_ARRAY_BUFFER, (GLuint)s.element_array_buffer);
+#endif
+    gl::bind_buffer(GL_ARRAY_BUFFER, (GLuint)s.array_buffer);
+    gl::blend_equation((GLenum)s.blend_equation_rgb,
+                       (GLenum)s.blend_equation_alpha);
+    gl::blend_func((GLenum)s.blend_src_rgb, (GLenum)s.blend_dst_rgb,
+                   (GLenum)s.blend_src_alpha, (GLenum)s.blend_dst_alpha);
+    gl::set_enabled(GL_BLEND, s.blend);
+    gl::set_enabled(GL_CULL_FACE, s.cull_face);
+    gl::set_enabled(GL_DEPTH_TEST, s.depth_test);
+    gl::set_enabled(GL_STENCIL_TEST, s.stencil_test);
+    gl::set_enabled(GL_SCISSOR_TEST, s.scissor_test);
+    gl::polygon_mode((GLenum)s.polygon_mode[0]);
+    gl::viewport(s.viewport[0], s.viewport[1], (GLsizei)s.viewport[2],
+                 (GLsizei)s.viewport[3]);
+    gl::scissor(s.scissor_box[0], s.scissor_box[1], (GLsizei)s.scissor_box[2],
+                (GLsizei)s.scissor_box[3]);
+}
+
+// Next buffer of the ring, once the GPU is done reading from it
+static stream_buffer& acquire() {
+    size_t index = next_buffer;
+#if defined(RENDERER_HAS_BUFFER_STORAGE)
+    if (mode == stream_mode::buffer_storage) {
+        GLsync fence = buffers[index].fence;
+        if (fence != nullptr && buffers.size() < max_buffers &&
+            glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+            buffers.insert(buffers.begin() + index, stream_buffer{});
+        }
+        stream_buffer& b = buffers[index];
+        if (b.fence != nullptr) {
+            GLenum result;
+            do {
+                result = glClientWaitSync(b.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                          1000000000);
+            } while (result == GL_TIMEOUT_EXPIRED);
+            glDeleteSync(b.fence);
+            b.fence = nullptr;
+        }
+    }
+#endif
+    next_buffer = (index + 1) % buffers.size();
+    stats.buffer_uploads++;
+    return buffers[index];
+}
+
+// Grow the buffer to hold size bytes, leaves it bound to GL_ARRAY_BUFFER
+static void reserve(stream_buffer& b, size_t size) {
+    if (b.buffer != 0 && b.capacity >= size) {
+        gl::bind_buffer(GL_ARRAY_BUFFER, b.buffer);
+        return;
+    }
+    size_t capacity = b.capacity > 0 ? b.capacity : min_capacity;
+    while (capacity < size) {
+        capacity *= 2;
+    }
+    b.capacity = capacity;
+#if defined(RENDERER_HAS_BUFFER_STORAGE)
+    if (mode == stream_mode::buffer_storage) {
+        // Storage is immutable, the GPU is done with the old buffer since
+        // its fence was waited for in acquire()
+        if (b.buffer != 0) {
+            glDeleteBuffers(1, &b.buffer);
+            gl::deleted_buffer(b.buffer);
+        }
+        glGenBuffers(1, &b.buffer);
+        gl::bind_buffer(GL_ARRAY_BUFFER, b.buffer);
+        GLbitfield flags =
+            GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        // Dynamic so glBufferSubData() still works if mapping fails
+        glBufferStorage(GL_ARRAY_BUFFER, (GLsizeiptr)capacity, nullptr,
+                        flags | GL_DYNAMIC_STORAGE_BIT);
+        b.mapped = (char*)glMapBufferRange(GL_ARRAY_BUFFER, 0,
+                                           (GLsizeiptr)capacity, flags);
+        return;
+    }
+#endif
+    if (b.buffer == 0) {
+        glGenBuffers(1, &b.buffer);
+    }
+    gl::bind_buffer(GL_ARRAY_BUFFER, b.buffer);
+}
+
+// Write every draw list of count draw data into one region of a stream
+// buffer, the vertices of all of them before their indices
+static stream_buffer& upload(ImDrawData* const* draw_data, int count,
+                             placement* placed) {
+    size_t vertex_size = 0;
+    size_t size = 0;
+    for (int i = 0; i < count; i++) {
+        vertex_size +=
+            (size_t)draw_data[i]->TotalVtxCount * sizeof(ImDrawVert);
+        size += (size_t)draw_data[i]->TotalIdxCount * sizeof(ImDrawIdx);
+    }
+    size += vertex_size;
+    stream_buffer& b = acquire();
+    reserve(b, size);
+
+    char* dst = nullptr;
+    if (mode == stream_mode::buffer_storage) {
+        dst = b.mapped;
+    } else {
+        // Orphan the storage the GPU may still be reading from
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)b.capacity, nullptr,
+                     GL_STREAM_DRAW);
+#if defined(RENDERER_HAS_MAP_BUFFER_RANGE)
+        if (mode == stream_mode::map_buffer_range) {
+            dst = (char*)glMapBufferRange(
+                GL_ARRAY_BUFFER, 0, (GLsizeiptr)size,
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT |
+                    GL_MAP_UNSYNCHRONIZED_BIT);
+        }
+#endif
+    }
+
+    stats.upload_bytes += size;
+    size_t vertex_offset = 0;
+    size_t index_end = vertex_size;
+    for (int i = 0; i < count; i++) {
+        placed[i] = {draw_data[i], b.buffer,
+                     vertex_offset / sizeof(ImDrawVert), index_end};
+        for (int n = 0; n < draw_data[i]->CmdListsCount; n++) {
+            const ImDrawList* cmd_list = draw_data[i]->CmdLists[n];
+            size_t vertices = (size_t)cmd_list->VtxBuffer.size_in_bytes();
+            size_t indices = (size_t)cmd_list->IdxBuffer.size_in_bytes();
+            if (dst != nullptr) {
+                memcpy(dst + vertex_offset, cmd_list->VtxBuffer.Data,
+                       vertices);
+                memcpy(dst + index_end, cmd_list->IdxBuffer.Data, indices);
+            } else {
+                glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)vertex_offset,
+                                (GLsizeiptr)vertices,
+                                cmd_list->VtxBuffer.Data);
+                glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)index_end,
+                                (GLsizeiptr)indices,
+                                cmd_list->IdxBuffer.Data);
+            }
+            vertex_offset += vertices;
+            index_end += indices;
+        }
+    }
+#if defined(RENDERER_HAS_MAP_BUFFER_RANGE)
+    if (mode == stream_mode::map_buffer_range && dst != nullptr) {
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+#endif
+    return b;
+}
+
+// Point the attributes at a draw list's vertices within the stream buffer.
+// Indices are relative to the list (and to ImDrawCmd::VtxOffset), so this
+// is done per list unless glDrawElementsBaseVertex() is available.
+static void set_vertex_pointers(size_t first_vertex) {
+    size_t base = first_vertex * sizeof(ImDrawVert);
+    GLsizei stride = sizeof(ImDrawVert);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride,
+                          (GLvoid*)(base + offsetof(ImDrawVert, pos)));
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride,
+                          (GLvoid*)(base + offsetof(ImDrawVert, uv)));
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride,
+                          (GLvoid*)(base + offsetof(ImDrawVert, col)));
+}
+
+// Same state as ImGui_ImplOpenGL3_SetupRenderState()
+static void setup_render_state(ImDrawData* draw_data, int fb_width,
+                               int fb_height, GLuint vertex_array,
+                               GLuint buffer) {
+    gl::set_enabled(GL_BLEND, true);
+    gl::blend_equation(GL_FUNC_ADD, GL_FUNC_ADD);
+    gl::blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE,
+                   GL_ONE_MINUS_SRC_ALPHA);
+    gl::set_enabled(GL_CULL_FACE, false);
+    gl::set_enabled(GL_DEPTH_TEST, false);
+    gl::set_enabled(GL_STENCIL_TEST, false);
+    gl::set_enabled(GL_SCISSOR_TEST, true);
+#if defined(GL_POLYGON_MODE)
+    gl::polygon_mode(GL_FILL);
+#endif
+
+    // Our visible imgui space lies from draw_data->DisplayPos (top left) to
+    // draw_data->DisplayPos + draw_data->DisplaySize (bottom right).
+    gl::viewport(0, 0, (GLsizei)fb_width, (GLsizei)fb_height);
+    float L = draw_data->DisplayPos.x;
+    float R = draw_data->DisplayPos.x + draw_data->DisplaySize.x;
+    float T = draw_data->DisplayPos.y;
+    float B = draw_data->DisplayPos.y + draw_data->DisplaySize.y;
+    const float ortho_projection[4][4] = {
+        {2.0f / (R - L), 0.0f, 0.0f, 0.0f},
+        {0.0f, 2.0f / (T - B), 0.0f, 0.0f},
+        {0.0f, 0.0f, -1.0f, 0.0f},
+        {(R + L) / (L - R), (T + B) / (B - T), 0.0f, 1.0f},
+    };
+    gl::use_program(program);
+    // Uniforms belong to the program, which every context shares
+    if (memcmp(projection, ortho_projection, sizeof(projection)) != 0) {
+        memcpy(projection, ortho_projection, sizeof(projection));
+        glUniformMatrix4fv(program_proj_mtx, 1, GL_FALSE, &projection[0][0]);
+    }
+    if (has_samplers) {
+        gl::bind_sampler(0);
+    }
+
+    gl::bind_vertex_array(vertex_array);
+    gl::bind_buffer(GL_ARRAY_BUFFER, buffer);
+    gl::bind_buffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+    set_vertex_pointers(0);
+    bound_vertex = 0;
+}
+
+static void draw_clipped(const batch& d, const ImVec4& clip_rect,
+                         size_t index_offset, int fb_height) {
+    gl::scissor((int)clip_rect.x, (int)(fb_height - clip_rect.w),
+                (int)(clip_rect.z - clip_rect.x),
+                (int)(clip_rect.w - clip_rect.y));
+    gl::bind_texture(d.texture);
+    GLenum index_type =
+        sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    GLvoid* indices =
+        (GLvoid*)(index_offset + d.first_index * sizeof(ImDrawIdx));
+#if defined(RENDERER_HAS_BASE_VERTEX)
+    if (has_base_vertex) {
+        glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)d.count, index_type,
+                                 indices, (GLint)d.first_vertex);
+        stats.draw_calls++;
+        return;
+    }
+#endif
+    if (bound_vertex != d.first_vertex) {
+        bound_vertex = d.first_vertex;
+        set_vertex_pointers(bound_vertex);
+    }
+    glDrawElements(GL_TRIANGLES, (GLsizei)d.count, index_type, indices);
+    stats.draw_calls++;
+}
+
+// Once per region the batch's clip rect overlaps. Regions do not overlap
+// each other, so nothing is blended twice.
+static void draw(const batch& d, size_t index_offset, int fb_height) {
+    if (regions == nullptr) {
+        draw_clipped(d, d.clip_rect, index_offset, fb_height);
+        return;
+    }
+    for (const ImVec4& r : *regions) {
+        ImVec4 clip_rect(
+            std::max(d.clip_rect.x, r.x), std::max(d.clip_rect.y, r.y),
+            std::min(d.clip_rect.z, r.z), std::min(d.clip_rect.w, r.w));
+        if (clip_rect.x < clip_rect.z && clip_rect.y < clip_rect.w) {
+            draw_clipped(d, clip_rect, index_offset, fb_height);
+        }
+    }
+}
+
+void render(ImDrawData* draw_data, const ImVector<ImVec4>* limit) {
+    int fb_width =
+        (int)(draw_data->DisplaySize.x * draw_data->FramebufferScale.x);
+    int fb_height =
+        (int)(draw_data->DisplaySize.y * draw_data->FramebufferScale.y);
+    if (fb_width <= 0 || fb_height <= 0 || draw_data->TotalVtxCount == 0 ||
+        (limit != nullptr && limit->empty())) {
+        return;
+    }
+    regions = limit;
+
+    gl::make_current(SDL_GL_GetCurrentContext());
+    gl::validate("before render");
+    saved_state saved;
+    if (preserve_state) {
+        save_state(saved);
+        gl::invalidate();
+    }
+
+    GLuint vertex_array = 0;
+#if defined(RENDERER_HAS_VERTEX_ARRAY)
+    bool own_vertex_array = false;
+    if (SDL_GL_GetCurrentContext() == main_context) {
+        vertex_array = main_vertex_array;
+    } else {
+        glGenVertexArrays(1, &vertex_array);
+        own_vertex_array = true;
+    }
+#endif
+    stream_buffer* b = nullptr;
+    placement placed;
+    for (size_t i = 0; i < placements.size(); i++) {
+        if (placements[i].draw_data == draw_data) {
+            placed = placements[i];
+            placements.erase(placements.begin() + i);
+            for (stream_buffer& candidate : buffers) {
+                if (candidate.buffer == placed.buffer) {
+                    b = &candidate;
+                }
+            }
+            break;
+        }
+    }
+    if (b == nullptr) {
+        b = &upload(&draw_data, 1, &placed);
+    }
+    size_t index_offset = placed.index_offset;
+    setup_render_state(draw_data, fb_width, fb_height, vertex_array,
+                       b->buffer);
+
+    // Project scissor/clipping rectangles into framebuffer space
+    ImVec2 clip_off = draw_data->DisplayPos;
+    ImVec2 clip_scale = draw_data->FramebufferScale;
+
+    size_t list_vertex = placed.first_vertex;
+    size_t list_index = 0;
+    batch pending = {};
+    for (int n = 0; n < draw_data->CmdListsCount; n++) {
+        const ImDrawList* cmd_list = draw_data->CmdLists[n];
+        for (const ImDrawCmd& cmd : cmd_list->CmdBuffer) {
+            if (cmd.UserCallback != nullptr) {
+                if (pending.count > 0) {
+                    draw(pending, index_offset, fb_height);
+                    pending.count = 0;
+                }
+                if (cmd.UserCallback == ImDrawCallback_ResetRenderState) {
+                    setup_render_state(draw_data, fb_width, fb_height,
+                                       vertex_array, b->buffer);
+                } else {
+                    // May change any state behind the cache's back
+                    cmd.UserCallback(cmd_list, &cmd);
+                    gl::invalidate();
+                }
+                continue;
+            }
+
+            ImVec4 clip_rect;
+            clip_rect.x = (cmd.ClipRect.x - clip_off.x) * clip_scale.x;
+            clip_rect.y = (cmd.ClipRect.y - clip_off.y) * clip_scale.y;
+            clip_rect.z = (cmd.ClipRect.z - clip_off.x) * clip_scale.x;
+            clip_rect.w = (cmd.ClipRect.w - clip_off.y) * clip_scale.y;
+            if (clip_rect.x >= fb_width || clip_rect.y >= fb_height ||
+                clip_rect.z < 0.0f || clip_rect.w < 0.0f) {
+                continue;
+            }
+            stats.draw_commands++;
+
+            batch next = {(GLuint)(intptr_t)cmd.TextureId, clip_rect,
+                          list_vertex + cmd.VtxOffset,
+                          list_index + cmd.IdxOffset, cmd.ElemCount};
+            if (pending.count > 0 && pending.texture == next.texture &&
+                memcmp(&pending.clip_rect, &next.clip_rect,
+                       sizeof(ImVec4)) == 0 &&
+                pending.first_vertex == next.first_vertex &&
+                pending.first_index + pending.count == next.first_index) {
+                pending.count += next.count;
+                continue;
+            }
+            if (pending.count > 0) {
+                draw(pending, index_offset, fb_height);
+            }
+            pending = next;
+        }
+        list_vertex += (size_t)cmd_list->VtxBuffer.Size;
+        list_index += (size_t)cmd_list->IdxBuffer.Size;
+    }
+    if (pending.count > 0) {
+        draw(pending, index_offset, fb_height);
+    }
+
+#if defined(RENDERER_HAS_BUFFER_STORAGE)
+    if (mode == stream_mode::buffer_storage) {
+        // Drawn from again by another viewport, the newer fence covers the
+        // earlier draws
+        if (b->fence != nullptr) {
+            glDeleteSync(b->fence);
+        }
+        b->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+#endif
+#if defined(RENDERER_HAS_VERTEX_ARRAY)
+    gl::bind_vertex_array(0);
+    if (own_vertex_array) {
+        glDeleteVertexArrays(1, &vertex_array);
+    }
+#endif
+    if (preserve_state) {
+        restore_state(saved);
+    }
+    gl::validate("after render");
+}
+
+void set_preserve_state(bool preserve) { preserve_state = preserve; }
+
+void upload_viewports() {
+    placements.clear();
+    std::vector<ImDrawData*> draw_data;
+    ImGuiPlatformIO& platform_io = ImGui::GetPlatformIO();
+    for (ImGuiViewport* viewport : platform_io.Viewports) {
+        ImDrawData* d = viewport->DrawData;
+        if (!(viewport->Flags & ImGuiViewportFlags_Minimized) &&
+            d != nullptr && d->TotalVtxCount > 0) {
+            draw_data.push_back(d);
+        }
+    }
+    if (draw_data.empty()) {
+        return;
+    }
+    placements.resize(draw_data.size());
+    upload(draw_data.data(), (int)draw_data.size(), placements.data());
+}
+
+frame_stats take_stats() {
+    frame_stats frame = stats;
+    stats = {};
+    return frame;
+}
+
+#if defined(RENDERER_HAS_SYNC)
+static double milliseconds(uint64_t begin, uint64_t end) {
+    return (double)(end - begin) * 1000.0 /
+           (double)SDL_GetPerformanceFrequency();
+}
+
+static void delete_frame_fences() {
+    for (frame_fence& f : frame_fences) {
+        glDeleteSync(f.fence);
+    }
+    frame_fences.clear();
+}
+#endif
+
+void set_max_frames_in_flight(int frames) {
+    max_frames_in_flight = frames;
+#if defined(RENDERER_HAS_SYNC)
+    if (frames == 0) {
+        delete_frame_fences();
+    }
+#endif
+}
+
+void frame_swapped(uint64_t input_time) {
+    // Viewports upload_viewports() wrote that were not drawn
+    placements.clear();
+#if defined(RENDERER_HAS_SYNC)
+    if (max_frames_in_flight > 0 && has_sync) {
+        frame_fences.push_back(
+            {glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), input_time});
+    }
+#else
+    (void)input_time;
+#endif
+}
+
+void wait_for_frames_in_flight() {
+#if defined(RENDERER_HAS_SYNC)
+    uint64_t begin = SDL_GetPerformanceCounter();
+    while (!frame_fences.empty() &&
+           (int)frame_fences.size() >= max_frames_in_flight) {
+        frame_fence f = frame_fences.front();
+        GLenum result;
+        do {
+            result = glClientWaitSync(f.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                      1000000000);
+        } while (result == GL_TIMEOUT_EXPIRED);
+        uint64_t end = SDL_GetPerformanceCounter();
+        glDeleteSync(f.fence);
+        frame_fences.erase(frame_fences.begin());
+        stats.input_latency_ms = milliseconds(f.input_time, end);
+    }
+    stats.gpu_wait_ms += milliseconds(begin, SDL_GetPerformanceCounter());
+#endif
+}
+
+static void render_window(ImGuiViewport* viewport, void*) {
+    // The clear goes through the state cache too, which has to be the one
+    // of this window's context
+    gl::make_current(SDL_GL_GetCurrentContext());
+    if (!(viewport->Flags & ImGuiViewportFlags_NoRendererClear)) {
+        gl::set_enabled(GL_SCISSOR_TEST, false);
+        gl::clear_color(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+    render(viewport->DrawData);
+}
+
+void load_shaders(const char* glsl_version) {
+    gl::init(glsl_version);
+    const char* vertex_source = "uniform mat4 ProjMtx;\n"
+                                "IN vec2 Position;\n"
+                                "IN vec2 UV;\n"
+                                "IN vec4 Color;\n"
+                                "OUT vec2 Frag_UV;\n"
+                                "OUT vec4 Frag_Color;\n"
+                                "void main() {\n"
+                                "    Frag_UV = UV;\n"
+                                "    Frag_Color = Color;\n"
+                                "    gl_Position = ProjMtx * "
+                                "vec4(Position.xy, 0, 1);\n"
+                                "}\n";
+    const char* fragment_source =
+        "uniform sampler2D Texture;\n"
+        "IN vec2 Frag_UV;\n"
+        "IN vec4 Frag_Color;\n"
+        "void main() {\n"
+        "    OUT_COLOR = Frag_Color * texture(Texture, Frag_UV.st);\n"
+        "}\n";
+    program = gl::create_program(vertex_source, fragment_source, "renderer");
+    if (program == 0) {
+        exit(1);
+    }
+}
+
+void init(const char* glsl_version) {
+    ImGuiIO& io = ImGui::GetIO();
+    io.BackendRendererName = "imgui-boilerplate";
+    // ImDrawCmd::VtxOffset is applied as the base vertex of the draw call,
+    // or through the attribute pointers
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasVtxOffset;
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasViewports;
+
+#if defined(RENDERER_HAS_BUFFER_STORAGE)
+    if (gl::has_version(4, 4) ||
+        gl::has_extension("GL_ARB_buffer_storage")) {
+        mode = stream_mode::buffer_storage;
+    } else
+#endif
+    {
+#if defined(RENDERER_HAS_MAP_BUFFER_RANGE)
+        mode = stream_mode::map_buffer_range;
+#else
+        mode = stream_mode::buffer_data;
+#endif
+    }
+    // Orphaning already hands out fresh storage, so a single buffer does
+    buffers.assign(1, stream_buffer{});
+    next_buffer = 0;
+#if defined(RENDERER_HAS_BASE_VERTEX)
+    has_base_vertex =
+        gl::has_version(3, 2) ||
+        gl::has_extension("GL_ARB_draw_elements_base_vertex");
+#endif
+#if defined(IMGUI_IMPL_OPENGL_ES2)
+    has_samplers = false;
+#elif defined(IMGUI_IMPL_OPENGL_ES3)
+    has_samplers = true;
+    has_sync = true;
+#else
+    has_samplers = gl::has_version(3, 3);
+    has_sync = gl::has_version(3, 2) || gl::has_extension("GL_ARB_sync");
+#endif
+
+    if (program == 0) {
+        load_shaders(glsl_version);
+    }
+    main_context = SDL_GL_GetCurrentContext();
+#if defined(RENDERER_HAS_VERTEX_ARRAY)
+    glGenVertexArrays(1, &main_vertex_array);
+#endif
+    program_proj_mtx = glGetUniformLocation(program, "ProjMtx");
+    program_texture = glGetUniformLocation(program, "Texture");
+    gl::use_program(program);
+    glUniform1i(program_texture, 0);
+    memset(projection, 0, sizeof(projection));
+
+    if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable) {
+        ImGui::GetPlatformIO().Renderer_RenderWindow = render_window;
+    }
+}
+
+void shutdown() {
+    ImGui::DestroyPlatformWindows();
+    for (stream_buffer& b : buffers) {
+#if defined(RENDERER_HAS_BUFFER_STORAGE)
+        if (b.fence != nullptr) {
+            glDeleteSync(b.fence);
+        }
+#endif
+        if (b.buffer != 0) {
+            glDeleteBuffers(1, &b.buffer);
+            gl::deleted_buffer(b.buffer);
+        }
+    }
+    buffers.clear();
+    placements.clear();
+#if defined(RENDERER_HAS_VERTEX_ARRAY)
+    gl::bind_vertex_array(0);
+    glDeleteVertexArrays(1, &main_vertex_array);
+    main_vertex_array = 0;
+#endif
+#if defined(RENDERER_HAS_SYNC)
+    delete_frame_fences();
+#endif
+    glDeleteProgram(program);
+    program = 0;
+
+    ImGuiIO& io = ImGui::GetIO();
+    io.BackendRendererName = nullptr;
+    io.BackendFlags &= ~(ImGuiBackendFlags_RendererHasVtxOffset |
+                         ImGuiBackendFlags_RendererHasViewports);
+}
+
+} // namespace renderer
+} // namespace window
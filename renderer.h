@@ -0,0 +1,62 @@
+#pragma once
+
+// OpenGL renderer for ImGui draw data, in place of
+// ImGui_ImplOpenGL3_RenderDrawData().
+//
+// The vertices and indices of every draw list in a frame are written into
+// one contiguous region of a streaming buffer. Where GL_ARB_buffer_storage is
+// available the buffers are persistently mapped and reused round robin,
+// guarded by fences. Otherwise the buffer is orphaned and mapped
+// unsynchronised, or filled with glBufferSubData() on OpenGL ES 2.
+//
+// Lists are drawn from that region with glDrawElementsBaseVertex() where
+// available, and adjacent commands sharing a texture and clip rect are
+// merged into one draw call.
+
+#include "imgui.h"
+#include "window.h"
+
+namespace window {
+namespace renderer {
+
+// Compile the program, or load it from the program binary cache. Needs only
+// the OpenGL context, so it can run while the font atlas is built. Called
+// by init() otherwise.
+void load_shaders(const char* glsl_version);
+
+// After ImGui::CreateContext() with the OpenGL context current. Takes the
+// GLSL version that would be passed to ImGui_ImplOpenGL3_Init().
+void init(const char* glsl_version);
+void shutdown();
+
+// Only the framebuffer rectangles in limit are drawn to when given, in
+// pixels with a top left origin. They must not overlap.
+void render(ImDrawData* draw_data, const ImVector<ImVec4>* limit = nullptr);
+
+// Write the draw data of every viewport into one stream buffer region,
+// after ImGui::Render(). render() then draws them from there instead of
+// uploading each on its own. With window::config::shared_gl_context, as
+// the buffer has to be drawn from with the same context. Nothing else may
+// be rendered until every viewport is drawn.
+void upload_viewports();
+
+// Save the GL state before rendering and restore it after, instead of
+// leaving the renderer's state for the next frame
+void set_preserve_state(bool preserve);
+
+// Counters accumulated by render() since the last call
+frame_stats take_stats();
+
+// Frames the GPU may lag behind, 0 leaves it to the driver. Needs OpenGL
+// 3.2, GL_ARB_sync or OpenGL ES 3.0, otherwise it is ignored.
+void set_max_frames_in_flight(int frames);
+// After the main window's buffers are swapped. input_time is the
+// performance counter when the frame's input was read.
+void frame_swapped(uint64_t input_time);
+// Before reading input for the next frame, until no more frames than the
+// maximum are in flight. The wait and latency go into the stats of the
+// frame about to start, the latency up to when the fence was polled.
+void wait_for_frames_in_flight();
+
+} // namespace renderer
+} // namespace window
@@ -0,0 +1,232 @@
+#include "sdf_font.h"
+
+#include "imgui.h"
+#include "opengl.h"
+#include "thread_pool.h"
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+// The copy of stb_truetype compiled into imgui_draw.cpp is static, so we
+// compile our own for the distance field rasteriser.
+#define STBTT_STATIC
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "imstb_truetype.h"
+
+namespace window {
+namespace sdf {
+
+// Distance field spread in pixels on each side of the outline, at base_size.
+static const int padding = 4;
+static const unsigned char on_edge_value = 128;
+static const float pixel_dist_scale = (float)on_edge_value / (float)padding;
+
+// Only the space glyph is rasterised from the TTF as a regular bitmap glyph,
+// everything else is added as a custom rect holding the distance field.
+static const ImWchar source_ranges[] = {0x0020, 0x0020, 0};
+
+struct pending_glyph {
+    ImFontAtlas* atlas;
+    int rect_id;
+    int width;
+    int height;
+    unsigned char* pixels;
+};
+
+// Atlases may be built on worker threads, see font_atlas.cpp
+static std::mutex pending_glyphs_mutex;
+static std::vector<pending_glyph> pending_glyphs;
+
+static GLuint program;
+static bool program_failed;
+static GLint program_proj_mtx;
+static GLint program_texture;
+static GLuint renderer_program;
+static GLint renderer_proj_mtx;
+
+ImFont* add_font(ImFontAtlas* atlas, const void* compressed_ttf,
+                 int compressed_ttf_size, const ImWchar* glyph_ranges) {
+    ImFontConfig config;
+    config.GlyphRanges = source_ranges;
+    ImFont* font = atlas->AddFontFromMemoryCompressedTTF(
+        compressed_ttf, compressed_ttf_size, base_size, &config);
+    if (font == nullptr) {
+        return nullptr;
+    }
+
+    // The atlas keeps the decompressed TTF around until it is cleared
+    const ImFontConfig& source = atlas->ConfigData.back();
+    const unsigned char* data = (const unsigned char*)source.FontData;
+    stbtt_fontinfo info;
+    if (!stbtt_InitFont(&info, data,
+                        stbtt_GetFontOffsetForIndex(data, source.FontNo))) {
+        fprintf(stderr, "Failed to parse font for distance field glyphs\n");
+        return font;
+    }
+
+    // Match the ascent rounding done by ImFontAtlasBuildWithStbTruetype so
+    // custom glyphs share the baseline of the font they are added to.
+    float scale = stbtt_ScaleForPixelHeight(&info, base_size);
+    int unscaled_ascent, unscaled_descent, unscaled_line_gap;
+    stbtt_GetFontVMetrics(&info, &unscaled_ascent, &unscaled_descent,
+                          &unscaled_line_gap);
+    float ascent = (float)(int)(unscaled_ascent * scale +
+                                ((unscaled_ascent > 0) ? 1.0f : -1.0f));
+
+    struct glyph_sdf {
+        unsigned int codepoint;
+        int advance;
+        int width, height, x_offset, y_offset;
+        unsigned char* pixels;
+    };
+    std::vector<glyph_sdf> glyphs;
+    if (glyph_ranges == nullptr) {
+        glyph_ranges = atlas->GetGlyphRangesDefault();
+    }
+    for (const ImWchar* range = glyph_ranges; range[0]; range += 2) {
+        for (unsigned int c = range[0]; c <= range[1]; c++) {
+            if (c != ' ' && stbtt_FindGlyphIndex(&info, (int)c) != 0) {
+                glyphs.push_back({c, 0, 0, 0, 0, 0, nullptr});
+            }
+        }
+    }
+
+    // Distance fields are expensive to compute, spread them over the pool
+    thread_pool::parallel_for((int)glyphs.size(), [&](int i) {
+        glyph_sdf& g = glyphs[i];
+        int glyph = stbtt_FindGlyphIndex(&info, (int)g.codepoint);
+        int left_side_bearing;
+        stbtt_GetGlyphHMetrics(&info, glyph, &g.advance, &left_side_bearing);
+        g.pixels = stbtt_GetGlyphSDF(&info, scale, glyph, padding,
+                                     on_edge_value, pixel_dist_scale,
+                                     &g.width, &g.height, &g.x_offset,
+                                     &g.y_offset);
+        if (g.pixels == nullptr) {
+            // Blank glyphs (e.g. no-break space) only carry an advance,
+            // the atlas starts out cleared so a 1x1 rect stays empty.
+            g.width = g.height = 1;
+            g.x_offset = g.y_offset = 0;
+        }
+    });
+
+    std::lock_guard<std::mutex> lock(pending_glyphs_mutex);
+    for (const glyph_sdf& g : glyphs) {
+        int rect_id = atlas->AddCustomRectFontGlyph(
+            font, (ImWchar)g.codepoint, g.width, g.height, g.advance * scale,
+            ImVec2((float)g.x_offset, (float)g.y_offset + ascent));
+        if (g.pixels != nullptr) {
+            pending_glyphs.push_back(
+                {atlas, rect_id, g.width, g.height, g.pixels});
+        }
+    }
+    return font;
+}
+
+void build(ImFontAtlas* atlas) {
+    atlas->Build();
+    unsigned char* tex_pixels;
+    int tex_width, tex_height;
+    atlas->GetTexDataAsAlpha8(&tex_pixels, &tex_width, &tex_height);
+    std::lock_guard<std::mutex> lock(pending_glyphs_mutex);
+    for (auto it = pending_glyphs.begin(); it != pending_glyphs.end();) {
+        if (it->atlas != atlas) {
+            ++it;
+            continue;
+        }
+        const ImFontAtlasCustomRect* rect =
+            atlas->GetCustomRectByIndex(it->rect_id);
+        for (int y = 0; y < it->height; y++) {
+            memcpy(tex_pixels + (rect->Y + y) * tex_width + rect->X,
+                   it->pixels + y * it->width, it->width);
+        }
+        stbtt_FreeSDF(it->pixels, nullptr);
+        it = pending_glyphs.erase(it);
+    }
+}
+
+void shutdown() {
+    if (program != 0) {
+        glDeleteProgram(program);
+    }
+    program = 0;
+    program_failed = false;
+    renderer_program = 0;
+    std::lock_guard<std::mutex> lock(pending_glyphs_mutex);
+    for (const pending_glyph& glyph : pending_glyphs) {
+        stbtt_FreeSDF(glyph.pixels, nullptr);
+    }
+    pending_glyphs.clear();
+}
+
+static bool create_program() {
+    const char* vertex_source = "uniform mat4 ProjMtx;\n"
+                                "IN vec2 Position;\n"
+                                "IN vec2 UV;\n"
+                                "IN vec4 Color;\n"
+                                "OUT vec2 Frag_UV;\n"
+                                "OUT vec4 Frag_Color;\n"
+                                "void main() {\n"
+                                "    Frag_UV = UV;\n"
+                                "    Frag_Color = Color;\n"
+                                "    gl_Position = ProjMtx * "
+                                "vec4(Position.xy, 0, 1);\n"
+                                "}\n";
+
+    // Antialias over one screen pixel around the outline, whatever the scale
+    const char* fragment_source =
+        "uniform sampler2D Texture;\n"
+        "IN vec2 Frag_UV;\n"
+        "IN vec4 Frag_Color;\n"
+        "void main() {\n"
+        "    float distance = texture(Texture, Frag_UV.st).a;\n"
+        "    float width = fwidth(distance);\n"
+        "    float alpha = smoothstep(0.5 - width, 0.5 + width, distance);\n"
+        "    OUT_COLOR = vec4(Frag_Color.rgb, Frag_Color.a * alpha);\n"
+        "}\n";
+
+    program = gl::create_program(vertex_source, fragment_source,
+                                 "distance field");
+    if (program == 0) {
+        return false;
+    }
+    program_proj_mtx = glGetUniformLocation(program, "ProjMtx");
+    program_texture = glGetUniformLocation(program, "Texture");
+    return true;
+}
+
+// Runs inside renderer::render() with the renderer's program bound. The
+// projection is taken from it so every viewport works unchanged.
+static void use_program(const ImDrawList*, const ImDrawCmd*) {
+    GLuint current = gl::current_program();
+    if (program == 0) {
+        if (program_failed) {
+            return;
+        }
+        if (!create_program()) {
+            program_failed = true;
+            return;
+        }
+    }
+    if (renderer_program != current) {
+        renderer_program = current;
+        renderer_proj_mtx = glGetUniformLocation(renderer_program, "ProjMtx");
+    }
+    GLfloat proj_mtx[16];
+    glGetUniformfv(renderer_program, renderer_proj_mtx, proj_mtx);
+    gl::use_program(program);
+    glUniform1i(program_texture, 0);
+    glUniformMatrix4fv(program_proj_mtx, 1, GL_FALSE, proj_mtx);
+}
+
+void begin_text() {
+    ImGui::GetWindowDrawList()->AddCallback(use_program, nullptr);
+}
+
+void end_text() {
+    ImGui::GetWindowDrawList()->AddCallback(ImDrawCallback_ResetRenderState,
+                                            nullptr);
+}
+
+} // namespace sdf
+} // namespace window
@@ -0,0 +1,36 @@
+#pragma once
+
+// Signed distance field fonts.
+//
+// A distance field glyph stores, per texel, the distance to the glyph outline
+// instead of its coverage. Sampled through the shader below it stays crisp
+// at any scale, so a single atlas entry per typeface serves every text size.
+
+#include "imgui.h"
+
+namespace window {
+namespace sdf {
+
+// Base rasterisation size of distance field glyphs, in pixels. Text is scaled
+// from this size with ImFont::Scale.
+constexpr float base_size = 32.0f;
+
+// Add a distance field font decoded from a compressed TTF (as produced by
+// binary_to_compressed_c.cpp). The glyph pixels are filled in by build().
+ImFont* add_font(ImFontAtlas* atlas, const void* compressed_ttf,
+                 int compressed_ttf_size,
+                 const ImWchar* glyph_ranges = nullptr);
+
+// Build the atlas and write the pending distance field glyphs into it.
+void build(ImFontAtlas* atlas);
+
+// The shader is compiled with gl::create_program() on first use
+void shutdown();
+
+// Switch the current window draw list to the distance field shader and back.
+// Must be balanced within the same window.
+void begin_text();
+void end_text();
+
+} // namespace sdf
+} // namespace window
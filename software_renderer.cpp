@@ -0,0 +1,479 @@
+#include "software_renderer.h"
+
+#include "thread_pool.h"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                   \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SOFTWARE_HAS_SSE2
+#endif
+
+namespace window {
+namespace software {
+
+static const int tile_size = 64;
+
+struct texture {
+    int width;
+    int height;
+    bool alpha;
+    std::vector<unsigned char> pixels;
+};
+
+// A draw list vertex in framebuffer pixels with its colour unpacked
+struct vertex {
+    float x, y;
+    float u, v;
+    float r, g, b, a;
+};
+
+struct triangle {
+    int v[3];
+    const texture* tex;
+    // Scissor rectangle, exclusive of x1 and y1
+    int x0, y0, x1, y1;
+};
+
+static std::vector<uint32_t> pixels;
+static int width;
+static int height;
+static std::vector<vertex> vertices;
+static std::vector<triangle> triangles;
+// Triangles overlapping each tile, in submission order
+static std::vector<std::vector<int>> tiles;
+static frame_stats stats;
+
+void init() {
+    ImGuiIO& io = ImGui::GetIO();
+    io.BackendRendererName = "imgui-boilerplate-software";
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasVtxOffset;
+}
+
+void shutdown() {
+    ImGuiIO& io = ImGui::GetIO();
+    io.BackendRendererName = nullptr;
+    io.BackendFlags &= ~ImGuiBackendFlags_RendererHasVtxOffset;
+    pixels.clear();
+    vertices.clear();
+    triangles.clear();
+    tiles.clear();
+}
+
+ImTextureID create_texture(const unsigned char* data, int w, int h,
+                           bool alpha) {
+    texture* t = new texture();
+    t->width = w;
+    t->height = h;
+    t->alpha = alpha;
+    t->pixels.assign(data, data + (size_t)w * h * (alpha ? 1 : 4));
+    return (ImTextureID)t;
+}
+
+void destroy_texture(ImTextureID id) { delete (texture*)id; }
+
+const unsigned char* texture_pixels(ImTextureID id, int* w, int* h,
+                                    bool* alpha) {
+    const texture* t = (const texture*)id;
+    *w = t->width;
+    *h = t->height;
+    *alpha = t->alpha;
+    return t->pixels.data();
+}
+
+static float channel(uint32_t c, int shift) {
+    return (float)((c >> shift) & 0xFF) * (1.0f / 255.0f);
+}
+
+static uint32_t to_byte(float f) {
+    return (uint32_t)(std::min(std::max(f, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+// Texel as r, g, b, a
+static void texel(const texture* t, int x, int y, float* out) {
+    x = std::min(std::max(x, 0), t->width - 1);
+    y = std::min(std::max(y, 0), t->height - 1);
+    size_t i = (size_t)y * t->width + x;
+    if (t->alpha) {
+        out[0] = out[1] = out[2] = 1.0f;
+        out[3] = t->pixels[i] * (1.0f / 255.0f);
+        return;
+    }
+    const unsigned char* p = &t->pixels[i * 4];
+    for (int c = 0; c < 4; c++) {
+        out[c] = p[c] * (1.0f / 255.0f);
+    }
+}
+
+// Same as GL_LINEAR
+static void sample(const texture* t, float u, float v, float* out) {
+    if (t == nullptr) {
+        out[0] = out[1] = out[2] = out[3] = 1.0f;
+        return;
+    }
+    float x = u * t->width - 0.5f;
+    float y = v * t->height - 0.5f;
+    float fx = floorf(x);
+    float fy = floorf(y);
+    int ix = (int)fx;
+    int iy = (int)fy;
+    fx = x - fx;
+    fy = y - fy;
+    float a[4], b[4], c[4], d[4];
+    texel(t, ix, iy, a);
+    texel(t, ix + 1, iy, b);
+    texel(t, ix, iy + 1, c);
+    texel(t, ix + 1, iy + 1, d);
+    for (int i = 0; i < 4; i++) {
+        float top = a[i] + (b[i] - a[i]) * fx;
+        float bottom = c[i] + (d[i] - c[i]) * fx;
+        out[i] = top + (bottom - top) * fy;
+    }
+}
+
+// GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA for colour and GL_ONE,
+// GL_ONE_MINUS_SRC_ALPHA for alpha
+static void blend(uint32_t* dst, const float* src) {
+    float a = src[3];
+    if (a <= 0.0f) {
+        return;
+    }
+    float inv = 1.0f - a;
+    uint32_t d = *dst;
+    uint32_t r = to_byte(src[0] * a + channel(d, 16) * inv);
+    uint32_t g = to_byte(src[1] * a + channel(d, 8) * inv);
+    uint32_t b = to_byte(src[2] * a + channel(d, 0) * inv);
+    uint32_t out_a = to_byte(a + channel(d, 24) * inv);
+    *dst = out_a << 24 | r << 16 | g << 8 | b;
+}
+
+#if defined(SOFTWARE_HAS_SSE2)
+// blend() for four adjacent pixels of one colour, given as b, g, r, a
+// premultiplied by a, the order of the bytes of a pixel in memory
+static void blend_span(uint32_t* dst, __m128 src, __m128 inv) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 to_float = _mm_set1_ps(1.0f / 255.0f);
+    const __m128 scale = _mm_set1_ps(255.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    __m128i d = _mm_loadu_si128((const __m128i*)dst);
+    __m128i lo = _mm_unpacklo_epi8(d, zero);
+    __m128i hi = _mm_unpackhi_epi8(d, zero);
+    __m128i in[4] = {_mm_unpacklo_epi16(lo, zero),
+                     _mm_unpackhi_epi16(lo, zero),
+                     _mm_unpacklo_epi16(hi, zero),
+                     _mm_unpackhi_epi16(hi, zero)};
+    __m128i out[4];
+    for (int i = 0; i < 4; i++) {
+        __m128 c = _mm_mul_ps(_mm_cvtepi32_ps(in[i]), to_float);
+        c = _mm_add_ps(src, _mm_mul_ps(c, inv));
+        out[i] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(c, scale), half));
+    }
+    __m128i packed = _mm_packus_epi16(_mm_packs_epi32(out[0], out[1]),
+                                      _mm_packs_epi32(out[2], out[3]));
+    _mm_storeu_si128((__m128i*)dst, packed);
+}
+#endif
+
+// w = a * x + b * y + c, positive inside for the triangle's winding
+struct edge {
+    float a, b, c;
+    // Pixels exactly on the edge belong to one of the two triangles
+    // sharing it
+    bool inclusive;
+};
+
+static edge make_edge(const vertex& p, const vertex& q) {
+    edge e;
+    e.a = p.y - q.y;
+    e.b = q.x - p.x;
+    e.c = p.x * q.y - p.y * q.x;
+    e.inclusive = e.a > 0.0f || (e.a == 0.0f && e.b > 0.0f);
+    return e;
+}
+
+static void shade(const triangle& t, const vertex* v[3], const edge* e,
+                  float inv_area, bool flat, const float* flat_color, int x,
+                  int y) {
+    uint32_t* dst = &pixels[(size_t)y * width + x];
+    if (flat) {
+        blend(dst, flat_color);
+        return;
+    }
+    float px = x + 0.5f;
+    float py = y + 0.5f;
+    float l1 = (e[1].a * px + e[1].b * py + e[1].c) * inv_area;
+    float l2 = (e[2].a * px + e[2].b * py + e[2].c) * inv_area;
+    float l0 = 1.0f - l1 - l2;
+    float color[4];
+    sample(t.tex, v[0]->u * l0 + v[1]->u * l1 + v[2]->u * l2,
+           v[0]->v * l0 + v[1]->v * l1 + v[2]->v * l2, color);
+    color[0] *= v[0]->r * l0 + v[1]->r * l1 + v[2]->r * l2;
+    color[1] *= v[0]->g * l0 + v[1]->g * l1 + v[2]->g * l2;
+    color[2] *= v[0]->b * l0 + v[1]->b * l1 + v[2]->b * l2;
+    color[3] *= v[0]->a * l0 + v[1]->a * l1 + v[2]->a * l2;
+    blend(dst, color);
+}
+
+static void rasterise(const triangle& t, int tile_x0, int tile_y0,
+                      int tile_x1, int tile_y1) {
+    const vertex* v[3] = {&vertices[t.v[0]], &vertices[t.v[1]],
+                          &vertices[t.v[2]]};
+    float area = (v[1]->x - v[0]->x) * (v[2]->y - v[0]->y) -
+                 (v[1]->y - v[0]->y) * (v[2]->x - v[0]->x);
+    if (area == 0.0f) {
+        return;
+    }
+    if (area < 0.0f) {
+        std::swap(v[1], v[2]);
+        area = -area;
+    }
+    // Edge i is opposite vertex i, so w_i / area is its barycentric weight
+    edge e[3] = {make_edge(*v[1], *v[2]), make_edge(*v[2], *v[0]),
+                 make_edge(*v[0], *v[1])};
+    float inv_area = 1.0f / area;
+
+    int x0 = std::max({(int)floorf(std::min({v[0]->x, v[1]->x, v[2]->x})),
+                       t.x0, tile_x0});
+    int y0 = std::max({(int)floorf(std::min({v[0]->y, v[1]->y, v[2]->y})),
+                       t.y0, tile_y0});
+    int x1 = std::min({(int)ceilf(std::max({v[0]->x, v[1]->x, v[2]->x})),
+                       t.x1, tile_x1});
+    int y1 = std::min({(int)ceilf(std::max({v[0]->y, v[1]->y, v[2]->y})),
+                       t.y1, tile_y1});
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+
+    // Solid shapes only ever sample the atlas's white texel
+    bool flat = v[0]->u == v[1]->u && v[0]->u == v[2]->u &&
+                v[0]->v == v[1]->v && v[0]->v == v[2]->v &&
+                v[0]->r == v[1]->r && v[0]->r == v[2]->r &&
+                v[0]->g == v[1]->g && v[0]->g == v[2]->g &&
+                v[0]->b == v[1]->b && v[0]->b == v[2]->b &&
+                v[0]->a == v[1]->a && v[0]->a == v[2]->a;
+    float flat_color[4];
+    if (flat) {
+        sample(t.tex, v[0]->u, v[0]->v, flat_color);
+        flat_color[0] *= v[0]->r;
+        flat_color[1] *= v[0]->g;
+        flat_color[2] *= v[0]->b;
+        flat_color[3] *= v[0]->a;
+        if (flat_color[3] <= 0.0f) {
+            return;
+        }
+    }
+
+#if defined(SOFTWARE_HAS_SSE2)
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+    __m128 a[3], inclusive[3];
+    __m128 flat_src = zero, flat_inv = zero;
+    if (flat) {
+        float alpha = flat_color[3];
+        flat_src = _mm_set_ps(alpha, flat_color[0] * alpha,
+                              flat_color[1] * alpha, flat_color[2] * alpha);
+        flat_inv = _mm_set1_ps(1.0f - alpha);
+    }
+    for (int i = 0; i < 3; i++) {
+        a[i] = _mm_set1_ps(e[i].a);
+        inclusive[i] =
+            _mm_castsi128_ps(_mm_set1_epi32(e[i].inclusive ? -1 : 0));
+    }
+    for (int y = y0; y < y1; y++) {
+        float py = y + 0.5f;
+        __m128 row[3];
+        for (int i = 0; i < 3; i++) {
+            row[i] = _mm_set1_ps(e[i].b * py + e[i].c);
+        }
+        for (int x = x0; x < x1; x += 4) {
+            __m128 px = _mm_add_ps(_mm_set1_ps((float)x), offsets);
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int i = 0; i < 3; i++) {
+                __m128 w = _mm_add_ps(_mm_mul_ps(a[i], px), row[i]);
+                __m128 on_edge = _mm_and_ps(_mm_cmpeq_ps(w, zero),
+                                            inclusive[i]);
+                inside = _mm_and_ps(
+                    inside, _mm_or_ps(_mm_cmpgt_ps(w, zero), on_edge));
+            }
+            int mask = _mm_movemask_ps(inside);
+            // Lanes past the end of the span
+            mask &= (1 << std::min(4, x1 - x)) - 1;
+            // Pixels outside the mask may belong to another tile's thread,
+            // only whole spans are written at once
+            if (flat && mask == 0xF) {
+                blend_span(&pixels[(size_t)y * width + x], flat_src,
+                           flat_inv);
+                continue;
+            }
+            for (int lane = 0; mask != 0; lane++, mask >>= 1) {
+                if (mask & 1) {
+                    shade(t, v, e, inv_area, flat, flat_color, x + lane, y);
+                }
+            }
+        }
+    }
+#else
+    for (int y = y0; y < y1; y++) {
+        float py = y + 0.5f;
+        for (int x = x0; x < x1; x++) {
+            float px = x + 0.5f;
+            bool inside = true;
+            for (int i = 0; i < 3 && inside; i++) {
+                float w = e[i].a * px + e[i].b * py + e[i].c;
+                inside = w > 0.0f || (w == 0.0f && e[i].inclusive);
+            }
+            if (inside) {
+                shade(t, v, e, inv_area, flat, flat_color, x, y);
+            }
+        }
+    }
+#endif
+}
+
+// Unpack the vertices and bin every triangle into the tiles it overlaps
+static void bin(ImDrawData* draw_data) {
+    ImVec2 offset = draw_data->DisplayPos;
+    ImVec2 scale = draw_data->FramebufferScale;
+    int tiles_x = (width + tile_size - 1) / tile_size;
+    int tiles_y = (height + tile_size - 1) / tile_size;
+    tiles.resize((size_t)tiles_x * tiles_y);
+    for (std::vector<int>& tile : tiles) {
+        tile.clear();
+    }
+    vertices.resize((size_t)draw_data->TotalVtxCount);
+    triangles.clear();
+
+    size_t list_vertex = 0;
+    for (int n = 0; n < draw_data->CmdListsCount; n++) {
+        const ImDrawList* cmd_list = draw_data->CmdLists[n];
+        for (int i = 0; i < cmd_list->VtxBuffer.Size; i++) {
+            const ImDrawVert& src = cmd_list->VtxBuffer[i];
+            vertex& dst = vertices[list_vertex + i];
+            dst.x = (src.pos.x - offset.x) * scale.x;
+            dst.y = (src.pos.y - offset.y) * scale.y;
+            dst.u = src.uv.x;
+            dst.v = src.uv.y;
+            dst.r = channel(src.col, IM_COL32_R_SHIFT);
+            dst.g = channel(src.col, IM_COL32_G_SHIFT);
+            dst.b = channel(src.col, IM_COL32_B_SHIFT);
+            dst.a = channel(src.col, IM_COL32_A_SHIFT);
+        }
+
+        for (const ImDrawCmd& cmd : cmd_list->CmdBuffer) {
+            // Callbacks expect an OpenGL context, there is none to give them
+            if (cmd.UserCallback != nullptr) {
+                continue;
+            }
+            // The same rectangle glScissor() gets from the OpenGL renderer
+            float clip_x = (cmd.ClipRect.x - offset.x) * scale.x;
+            float clip_y = (cmd.ClipRect.y - offset.y) * scale.y;
+            float clip_z = (cmd.ClipRect.z - offset.x) * scale.x;
+            float clip_w = (cmd.ClipRect.w - offset.y) * scale.y;
+            int x0 = std::max((int)clip_x, 0);
+            int y0 = std::max((int)clip_y, 0);
+            int x1 = std::min((int)clip_x + (int)(clip_z - clip_x), width);
+            int y1 = std::min((int)clip_y + (int)(clip_w - clip_y), height);
+            if (x0 >= x1 || y0 >= y1) {
+                continue;
+            }
+            stats.draw_commands++;
+
+            const texture* tex = (const texture*)cmd.TextureId;
+            size_t first = list_vertex + cmd.VtxOffset;
+            for (unsigned int i = 0; i < cmd.ElemCount; i += 3) {
+                const ImDrawIdx* idx =
+                    &cmd_list->IdxBuffer[(int)(cmd.IdxOffset + i)];
+                triangle t = {{(int)(first + idx[0]), (int)(first + idx[1]),
+                               (int)(first + idx[2])},
+                              tex, x0, y0, x1, y1};
+                const vertex& a = vertices[t.v[0]];
+                const vertex& b = vertices[t.v[1]];
+                const vertex& c = vertices[t.v[2]];
+                int bx0 = std::max((int)floorf(std::min({a.x, b.x, c.x})),
+                                   x0);
+                int by0 = std::max((int)floorf(std::min({a.y, b.y, c.y})),
+                                   y0);
+                int bx1 = std::min((int)ceilf(std::max({a.x, b.x, c.x})),
+                                   x1);
+                int by1 = std::min((int)ceilf(std::max({a.y, b.y, c.y})),
+                                   y1);
+                if (bx0 >= bx1 || by0 >= by1) {
+                    continue;
+                }
+                int index = (int)triangles.size();
+                triangles.push_back(t);
+                for (int ty = by0 / tile_size; ty <= (by1 - 1) / tile_size;
+                     ty++) {
+                    for (int tx = bx0 / tile_size;
+                         tx <= (bx1 - 1) / tile_size; tx++) {
+                        tiles[(size_t)ty * tiles_x + tx].push_back(index);
+                    }
+                }
+            }
+        }
+        list_vertex += (size_t)cmd_list->VtxBuffer.Size;
+    }
+}
+
+void render(ImDrawData* draw_data, const ImVec4& clear_color) {
+    width = (int)(draw_data->DisplaySize.x * draw_data->FramebufferScale.x);
+    height = (int)(draw_data->DisplaySize.y * draw_data->FramebufferScale.y);
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+    // Premultiplied like the clear of the OpenGL path
+    uint32_t clear = to_byte(clear_color.w) << 24 |
+                     to_byte(clear_color.x * clear_color.w) << 16 |
+                     to_byte(clear_color.y * clear_color.w) << 8 |
+                     to_byte(clear_color.z * clear_color.w);
+    pixels.assign((size_t)width * height, clear);
+    bin(draw_data);
+
+    int tiles_x = (width + tile_size - 1) / tile_size;
+    thread_pool::parallel_for((int)tiles.size(), [tiles_x](int i) {
+        int x0 = (i % tiles_x) * tile_size;
+        int y0 = (i / tiles_x) * tile_size;
+        int x1 = std::min(x0 + tile_size, width);
+        int y1 = std::min(y0 + tile_size, height);
+        for (int index : tiles[i]) {
+            rasterise(triangles[index], x0, y0, x1, y1);
+        }
+    });
+}
+
+void present(SDL_Window* window) {
+    SDL_Surface* surface = SDL_GetWindowSurface(window);
+    if (surface == nullptr || pixels.empty()) {
+        return;
+    }
+    int w = std::min(width, surface->w);
+    int h = std::min(height, surface->h);
+    if (SDL_MUSTLOCK(surface)) {
+        SDL_LockSurface(surface);
+    }
+    SDL_ConvertPixels(w, h, SDL_PIXELFORMAT_ARGB8888, pixels.data(),
+                      width * 4, surface->format->format, surface->pixels,
+                      surface->pitch);
+    if (SDL_MUSTLOCK(surface)) {
+        SDL_UnlockSurface(surface);
+    }
+    SDL_UpdateWindowSurface(window);
+}
+
+const uint32_t* framebuffer(int* w, int* h) {
+    *w = width;
+    *h = height;
+    return pixels.data();
+}
+
+frame_stats take_stats() {
+    frame_stats frame = stats;
+    stats = {};
+    return frame;
+}
+
+} // namespace software
+} // namespace window
@@ -0,0 +1,48 @@
+#pragma once
+
+// CPU rasteriser for ImGui draw data, for machines without a GPU or OpenGL
+// driver.
+//
+// Triangles are binned into square tiles of the framebuffer, then the tiles
+// are drawn on the thread pool, each one rasterising its triangles in
+// submission order. Coverage is tested four pixels at a time with edge
+// functions, using SSE2 where available, which also blends runs of four
+// pixels of solid shapes at once. Textures are sampled bilinearly
+// and blended the same way as the OpenGL renderer.
+
+#include "imgui.h"
+#include "window.h"
+#include <SDL.h>
+#include <stdint.h>
+
+namespace window {
+namespace software {
+
+// After ImGui::CreateContext()
+void init();
+void shutdown();
+
+// Textures are copied, the ImTextureID points at the copy. alpha selects
+// 8 bit coverage, sampled as white like the OpenGL renderer's R8 atlases.
+ImTextureID create_texture(const unsigned char* pixels, int width, int height,
+                           bool alpha);
+void destroy_texture(ImTextureID texture);
+// The copy create_texture() made, for comparing against other renderers
+const unsigned char* texture_pixels(ImTextureID texture, int* width,
+                                    int* height, bool* alpha);
+
+// Rasterise into the framebuffer, which is resized to the draw data's
+// framebuffer size and cleared to clear_color first
+void render(ImDrawData* draw_data, const ImVec4& clear_color);
+
+// Copy the framebuffer to the window's surface
+void present(SDL_Window* window);
+
+// 0xAARRGGBB pixels of the last frame, rows from the top
+const uint32_t* framebuffer(int* width, int* height);
+
+// Counters accumulated by render() since the last call
+frame_stats take_stats();
+
+} // namespace software
+} // namespace window
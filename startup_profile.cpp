@@ -0,0 +1,126 @@
+#include "startup_profile.h"
+
+#include "window.h"
+#include <SDL.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+
+namespace window {
+namespace startup_profile {
+
+static std::mutex mutex;
+static std::vector<startup_phase> phases;
+static uint64_t start_time;
+static uint64_t first_frame_start;
+static std::thread::id main_thread;
+// Phases finishing after the first frame are not part of startup
+static std::atomic<bool> active{false};
+
+static double seconds(uint64_t begin, uint64_t end) {
+    return (double)(int64_t)(end - begin) /
+           (double)SDL_GetPerformanceFrequency();
+}
+
+static void add(const char* name, uint64_t begin, uint64_t end) {
+    bool worker = std::this_thread::get_id() != main_thread;
+    std::lock_guard<std::mutex> lock(mutex);
+    // Checked again under the lock, finish() may have sorted the phases
+    // since the caller looked
+    if (!active) {
+        return;
+    }
+    phases.push_back(
+        {name, seconds(start_time, begin), seconds(begin, end), worker});
+}
+
+void start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    phases.clear();
+    start_time = SDL_GetPerformanceCounter();
+    first_frame_start = 0;
+    main_thread = std::this_thread::get_id();
+    active = true;
+}
+
+scope::scope(const char* name)
+    : name(name), begin(SDL_GetPerformanceCounter()) {}
+
+scope::~scope() {
+    if (active) {
+        add(name, begin, SDL_GetPerformanceCounter());
+    }
+}
+
+void frame_started() {
+    if (active && first_frame_start == 0) {
+        first_frame_start = SDL_GetPerformanceCounter();
+    }
+}
+
+void finish() {
+    if (!active) {
+        return;
+    }
+    uint64_t now = SDL_GetPerformanceCounter();
+    add("first frame", first_frame_start, now);
+    add("time to first frame", start_time, now);
+    {
+        // Workers' phases ending from here on are dropped by add()
+        std::lock_guard<std::mutex> lock(mutex);
+        active = false;
+        std::stable_sort(phases.begin(), phases.end(),
+                         [](const startup_phase& a, const startup_phase& b) {
+                             return a.start < b.start;
+                         });
+    }
+
+    const char* format = SDL_getenv("IMGUI_BOILERPLATE_STARTUP_PROFILE");
+    if (format != nullptr && format[0] != '\0') {
+        fputs(startup_profile_report(strcmp(format, "json") == 0).c_str(),
+              stderr);
+    }
+}
+
+} // namespace startup_profile
+
+const std::vector<startup_phase>& get_startup_profile() {
+    return startup_profile::phases;
+}
+
+std::string startup_profile_report(bool json) {
+    std::lock_guard<std::mutex> lock(startup_profile::mutex);
+    std::string report = json ? "[\n" : "";
+    char line[160];
+    if (!json) {
+        snprintf(line, sizeof(line), "%-24s %-6s %10s %10s\n", "phase",
+                 "thread", "start ms", "ms");
+        report += line;
+    }
+    const std::vector<startup_phase>& phases = startup_profile::phases;
+    for (size_t i = 0; i < phases.size(); i++) {
+        const startup_phase& p = phases[i];
+        if (json) {
+            // Phase names are literals without characters to escape
+            snprintf(line, sizeof(line),
+                     "  {\"phase\": \"%s\", \"worker\": %s, "
+                     "\"start_ms\": %.3f, \"ms\": %.3f}%s\n",
+                     p.name, p.worker ? "true" : "false", p.start * 1000.0,
+                     p.duration * 1000.0, i + 1 < phases.size() ? "," : "");
+        } else {
+            snprintf(line, sizeof(line), "%-24s %-6s %10.3f %10.3f\n",
+                     p.name, p.worker ? "worker" : "main", p.start * 1000.0,
+                     p.duration * 1000.0);
+        }
+        report += line;
+    }
+    if (json) {
+        report += "]\n";
+    }
+    return report;
+}
+
+} // namespace window
@@ -0,0 +1,37 @@
+#pragma once
+
+// Timestamps of the phases of window::init() and the first frame, see
+// window::get_startup_profile().
+//
+// Phases are recorded from any thread until the first frame is presented,
+// so work on worker threads shows up overlapping the main thread's phases.
+
+#include <stdint.h>
+
+namespace window {
+namespace startup_profile {
+
+// Start a new profile, at the top of window::init()
+void start();
+
+// Record the phase name from the construction of the scope until its
+// destruction. name must outlive the profile.
+struct scope {
+    explicit scope(const char* name);
+    ~scope();
+    scope(const scope&) = delete;
+    scope& operator=(const scope&) = delete;
+
+    const char* name;
+    uint64_t begin;
+};
+
+// Called by start_frame(), the first call starts the "first frame" phase
+void frame_started();
+
+// Called after a frame is presented, the first call ends the profile and
+// prints it when IMGUI_BOILERPLATE_STARTUP_PROFILE is set
+void finish();
+
+} // namespace startup_profile
+} // namespace window
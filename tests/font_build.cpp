@@ -0,0 +1,69 @@
+// Atlas build time with ImGui's serial builder and font_builder::parallel(),
+// for an application registering many fonts and sizes.
+//
+// Fails when the two atlases are not bit-identical.
+
+#include "font_builder.h"
+#include "fonts/FiraMono_Medium.h"
+#include "fonts/FiraMono_Regular.h"
+#include "fonts/FiraSans_Regular.h"
+#include "imgui.h"
+#include "imgui_internal.h"
+#include "thread_pool.h"
+#include <SDL.h>
+#include <stdio.h>
+#include <string.h>
+
+static const int runs = 5;
+
+static void add_fonts(ImFontAtlas* atlas) {
+    const unsigned int* data[] = {FiraMono_Regular_compressed_data,
+                                  FiraMono_Medium_compressed_data,
+                                  FiraSans_Regular_compressed_data};
+    const unsigned int sizes[] = {FiraMono_Regular_compressed_size,
+                                  FiraMono_Medium_compressed_size,
+                                  FiraSans_Regular_compressed_size};
+    const float pixels[] = {13.0f, 16.0f, 18.0f, 22.0f, 32.0f, 48.0f};
+    for (int font = 0; font < IM_ARRAYSIZE(data); font++) {
+        for (float size : pixels) {
+            atlas->AddFontFromMemoryCompressedTTF(
+                data[font], (int)sizes[font], size, nullptr,
+                atlas->GetGlyphRangesCyrillic());
+        }
+    }
+}
+
+// Fastest of a few builds, in milliseconds. atlas keeps the last one.
+static double build(ImFontAtlas* atlas, const ImFontBuilderIO* builder) {
+    double best = 0.0;
+    for (int i = 0; i < runs; i++) {
+        atlas->Clear();
+        add_fonts(atlas);
+        atlas->FontBuilderIO = builder;
+        Uint64 begin = SDL_GetPerformanceCounter();
+        atlas->Build();
+        double ms = (double)(SDL_GetPerformanceCounter() - begin) * 1000.0 /
+                    (double)SDL_GetPerformanceFrequency();
+        best = i == 0 || ms < best ? ms : best;
+    }
+    return best;
+}
+
+int main(int, char**) {
+    ImFontAtlas serial, parallel;
+    double serial_ms = build(&serial, ImFontAtlasGetBuilderForStbTruetype());
+    double parallel_ms = build(&parallel, window::font_builder::parallel());
+    printf("serial   %8.2f ms\n", serial_ms);
+    printf("parallel %8.2f ms on %d threads, %.0f%% less\n", parallel_ms,
+           window::thread_pool::size(),
+           (1.0 - parallel_ms / serial_ms) * 100.0);
+
+    if (serial.TexWidth != parallel.TexWidth ||
+        serial.TexHeight != parallel.TexHeight ||
+        memcmp(serial.TexPixelsAlpha8, parallel.TexPixelsAlpha8,
+               (size_t)serial.TexWidth * serial.TexHeight) != 0) {
+        fprintf(stderr, "Atlases differ\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,258 @@
+// The software renderer against the OpenGL renderer. A frame is drawn by
+// config::headless(), then its draw data is drawn again with OpenGL into a
+// framebuffer object and read back. Fails when more than max_differing of
+// the pixels differ by more than tolerance in any channel, as rasterisers
+// may disagree on coverage along edges.
+//
+// software_renderer [tolerance]
+//
+// Needs a display with OpenGL, skipped (exit code 77) without one.
+
+#include "window.h"
+#include "imgui.h"
+#include "opengl.h"
+#include "renderer.h"
+#include "software_renderer.h"
+#include <SDL.h>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+static const int width = 640;
+static const int height = 480;
+static const double max_differing = 0.005;
+
+// Whether an OpenGL window can be created here, before init() needs SDL
+static bool has_opengl() {
+    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+        return false;
+    }
+    SDL_Window* probe =
+        SDL_CreateWindow("probe", 0, 0, 16, 16,
+                         SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    SDL_GLContext context =
+        probe != nullptr ? SDL_GL_CreateContext(probe) : nullptr;
+    if (context != nullptr) {
+        SDL_GL_DeleteContext(context);
+    }
+    if (probe != nullptr) {
+        SDL_DestroyWindow(probe);
+    }
+    SDL_Quit();
+    return context != nullptr;
+}
+
+// Hidden OpenGL window, current, or false when there is no OpenGL here
+static bool create_gl_window(SDL_Window** window, SDL_GLContext* context) {
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK,
+                        SDL_GL_CONTEXT_PROFILE_CORE);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 2);
+    *window = SDL_CreateWindow("reference", 0, 0, 16, 16,
+                               SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    if (*window == nullptr) {
+        return false;
+    }
+    *context = SDL_GL_CreateContext(*window);
+    if (*context == nullptr) {
+        SDL_DestroyWindow(*window);
+        return false;
+    }
+    SDL_GL_MakeCurrent(*window, *context);
+    window::gl::make_current(*context);
+#if defined(IMGUI_IMPL_OPENGL_LOADER_GL3W)
+    if (gl3wInit() != 0) {
+        SDL_GL_DeleteContext(*context);
+        SDL_DestroyWindow(*window);
+        return false;
+    }
+#endif
+    return true;
+}
+
+// Widgets, text and shapes at fixed positions, nothing animated
+static void draw_scene() {
+    ImGui::SetNextWindowPos(ImVec2(20.0f, 20.0f));
+    ImGui::SetNextWindowSize(ImVec2(360.0f, 300.0f));
+    ImGui::Begin("Software renderer");
+    window::heading("Heading");
+    window::text("The quick brown fox jumps over the lazy dog");
+    ImGui::Button("Button");
+    static bool checked = true;
+    ImGui::Checkbox("Checkbox", &checked);
+    static float value = 0.4f;
+    ImGui::SliderFloat("Slider", &value, 0.0f, 1.0f);
+    ImGui::ProgressBar(0.6f);
+    ImGui::Separator();
+    ImDrawList* draw_list = ImGui::GetWindowDrawList();
+    ImVec2 p = ImGui::GetCursorScreenPos();
+    draw_list->AddRectFilled(p, ImVec2(p.x + 80.0f, p.y + 50.0f),
+                             IM_COL32(200, 40, 40, 255), 8.0f);
+    draw_list->AddCircleFilled(ImVec2(p.x + 130.0f, p.y + 25.0f), 24.0f,
+                               IM_COL32(40, 160, 40, 160));
+    draw_list->AddLine(ImVec2(p.x + 170.0f, p.y),
+                       ImVec2(p.x + 290.0f, p.y + 50.0f),
+                       IM_COL32(40, 40, 200, 255), 3.0f);
+    draw_list->AddRectFilledMultiColor(
+        ImVec2(p.x + 200.0f, p.y), ImVec2(p.x + 320.0f, p.y + 50.0f),
+        IM_COL32(255, 0, 0, 255), IM_COL32(0, 255, 0, 255),
+        IM_COL32(0, 0, 255, 128), IM_COL32(255, 255, 0, 64));
+    ImGui::Dummy(ImVec2(320.0f, 50.0f));
+    ImGui::End();
+}
+
+// GL textures standing in for the software renderer's, by TextureId
+struct texture_pair {
+    ImTextureID software;
+    GLuint gl;
+};
+
+static GLuint upload(ImTextureID id) {
+    int w, h;
+    bool alpha;
+    const unsigned char* pixels =
+        window::software::texture_pixels(id, &w, &h, &alpha);
+    // The renderer samples RGBA, coverage becomes white with alpha
+    std::vector<unsigned char> rgba((size_t)w * h * 4);
+    for (size_t i = 0; i < (size_t)w * h; i++) {
+        for (int c = 0; c < 4; c++) {
+            rgba[i * 4 + c] =
+                alpha ? (c < 3 ? 255 : pixels[i]) : pixels[i * 4 + c];
+        }
+    }
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, rgba.data());
+    return texture;
+}
+
+// Point the draw data at GL textures, uploading each one once
+static void use_gl_textures(ImDrawData* draw_data,
+                            std::vector<texture_pair>& textures) {
+    for (int n = 0; n < draw_data->CmdListsCount; n++) {
+        for (ImDrawCmd& cmd : draw_data->CmdLists[n]->CmdBuffer) {
+            if (cmd.UserCallback != nullptr) {
+                continue;
+            }
+            GLuint gl = 0;
+            for (const texture_pair& t : textures) {
+                if (t.software == cmd.TextureId) {
+                    gl = t.gl;
+                }
+            }
+            if (gl == 0) {
+                gl = upload(cmd.TextureId);
+                textures.push_back({cmd.TextureId, gl});
+            }
+            cmd.TextureId = (ImTextureID)(intptr_t)gl;
+        }
+    }
+}
+
+// Draw with OpenGL into a framebuffer object, as 0xAARRGGBB from the top
+static std::vector<uint32_t> render_gl(ImDrawData* draw_data, int w, int h) {
+    GLuint color, framebuffer;
+    glGenTextures(1, &color);
+    glBindTexture(GL_TEXTURE_2D, color);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, nullptr);
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                           GL_TEXTURE_2D, color, 0);
+    glViewport(0, 0, w, h);
+    // The boilerplate's clear colour, opaque white
+    glDisable(GL_SCISSOR_TEST);
+    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    // Textures were bound behind the state cache's back
+    window::gl::invalidate();
+    window::renderer::render(draw_data);
+
+    std::vector<unsigned char> rgba((size_t)w * h * 4);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteTextures(1, &color);
+
+    std::vector<uint32_t> pixels((size_t)w * h);
+    for (int y = 0; y < h; y++) {
+        // Framebuffers have a bottom left origin
+        const unsigned char* row = &rgba[(size_t)(h - 1 - y) * w * 4];
+        for (int x = 0; x < w; x++) {
+            const unsigned char* p = &row[x * 4];
+            pixels[(size_t)y * w + x] = (uint32_t)p[3] << 24 |
+                                        (uint32_t)p[0] << 16 |
+                                        (uint32_t)p[1] << 8 | p[2];
+        }
+    }
+    return pixels;
+}
+
+int main(int argc, char** argv) {
+    int tolerance = argc > 1 ? atoi(argv[1]) : 16;
+    if (!has_opengl()) {
+        fprintf(stderr, "No OpenGL display, skipped\n");
+        return 77;
+    }
+    window::config c = window::config::headless();
+    c.width = width;
+    c.height = height;
+    window::init(c);
+    ImGui::GetIO().IniFilename = nullptr;
+
+    SDL_Window* gl_window;
+    SDL_GLContext gl_context;
+    if (!create_gl_window(&gl_window, &gl_context)) {
+        fprintf(stderr, "Failed to create the OpenGL window\n");
+        window::destroy();
+        return 1;
+    }
+    window::renderer::init("#version 150");
+
+    // Layout settles over the first frames
+    for (int frame = 0; frame < 3; frame++) {
+        window::start_frame();
+        draw_scene();
+        window::end_frame();
+    }
+    int w, h;
+    const uint32_t* software = window::software_framebuffer(&w, &h);
+    std::vector<texture_pair> textures;
+    ImDrawData* draw_data = ImGui::GetDrawData();
+    use_gl_textures(draw_data, textures);
+    std::vector<uint32_t> gl = render_gl(draw_data, w, h);
+
+    size_t differing = 0;
+    int max_difference = 0;
+    for (size_t i = 0; i < (size_t)w * h; i++) {
+        int difference = 0;
+        for (int shift = 0; shift < 32; shift += 8) {
+            int a = (int)((software[i] >> shift) & 0xFF);
+            int b = (int)((gl[i] >> shift) & 0xFF);
+            difference = std::max(difference, abs(a - b));
+        }
+        max_difference = std::max(max_difference, difference);
+        differing += difference > tolerance;
+    }
+    double fraction = (double)differing / ((double)w * h);
+    printf("%dx%d pixels, %zu (%.3f%%) differ by more than %d, "
+           "largest difference %d\n",
+           w, h, differing, fraction * 100.0, tolerance, max_difference);
+
+    for (const texture_pair& t : textures) {
+        glDeleteTextures(1, &t.gl);
+    }
+    window::renderer::shutdown();
+    SDL_GL_DeleteContext(gl_context);
+    SDL_DestroyWindow(gl_window);
+    window::destroy();
+    return fraction > max_differing ? 1 : 0;
+}
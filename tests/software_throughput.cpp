@@ -0,0 +1,73 @@
+// Frames per second of the software renderer, headless at a full HD
+// framebuffer. The demo window is drawn over panels of solid rectangles,
+// the shapes the span blending is for, and of text.
+//
+// software_throughput [frames]
+
+#include "window.h"
+#include "imgui.h"
+#include <SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static const int width = 1920;
+static const int height = 1080;
+static const int warmup_frames = 10;
+
+static void draw_scene(int frame) {
+    ImGui::SetNextWindowPos(ImVec2(0.0f, 0.0f));
+    ImGui::SetNextWindowSize(ImVec2((float)width, (float)height));
+    ImGui::Begin("Panels", nullptr, ImGuiWindowFlags_NoDecoration);
+    ImDrawList* draw_list = ImGui::GetWindowDrawList();
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < 12; x++) {
+            ImVec2 p(x * 160.0f + 8.0f, y * 135.0f + 8.0f);
+            ImU32 color = IM_COL32(40 + x * 16, 40 + y * 24, 160, 200);
+            draw_list->AddRectFilled(p, ImVec2(p.x + 144.0f, p.y + 119.0f),
+                                     color, 6.0f);
+        }
+    }
+    for (int line = 0; line < 40; line++) {
+        ImGui::Text("Line %d of frame %d, the quick brown fox jumps over "
+                    "the lazy dog",
+                    line, frame);
+    }
+    ImGui::End();
+    ImGui::SetNextWindowPos(ImVec2(600.0f, 100.0f));
+    ImGui::SetNextWindowSize(ImVec2(700.0f, 800.0f));
+    ImGui::ShowDemoWindow();
+}
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? atoi(argv[1]) : 100;
+    window::config c = window::config::headless();
+    c.width = width;
+    c.height = height;
+    window::init(c);
+    ImGui::GetIO().IniFilename = nullptr;
+
+    double total_ms = 0.0;
+    int draw_commands = 0;
+    for (int frame = 0; frame < warmup_frames + frames; frame++) {
+        window::start_frame();
+        draw_scene(frame);
+        Uint64 begin = SDL_GetPerformanceCounter();
+        window::end_frame();
+        if (frame < warmup_frames) {
+            continue;
+        }
+        total_ms += (double)(SDL_GetPerformanceCounter() - begin) * 1000.0 /
+                    (double)SDL_GetPerformanceFrequency();
+        draw_commands += window::get_frame_stats().draw_commands;
+    }
+
+    int w, h;
+    window::software_framebuffer(&w, &h);
+    double frame_ms = total_ms / frames;
+    printf("%dx%d, %d frames: %.2f ms per frame, %.1f fps, "
+           "%.1f Mpixels/s, %d draw commands per frame\n",
+           w, h, frames, frame_ms, 1000.0 / frame_ms,
+           (double)w * h / (frame_ms * 1000.0), draw_commands / frames);
+    window::destroy();
+    return 0;
+}
@@ -0,0 +1,52 @@
+// Time to first frame of a headless window, see window::get_startup_profile().
+//
+// startup_time [budget ms] [--game-controllers]
+//
+// Prints the startup profile and fails when the time to first frame is
+// above the budget. With --game-controllers the controller subsystem is
+// started in init() instead of on first use, its phase in the profile is
+// what starting it lazily saves.
+
+#include "window.h"
+#include "imgui.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, char** argv) {
+    double budget_ms = 0.0;
+    window::config c = window::config::headless();
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--game-controllers") == 0) {
+            c.game_controllers = true;
+        } else {
+            budget_ms = atof(argv[i]);
+        }
+    }
+
+    window::init(c);
+    ImGui::GetIO().IniFilename = nullptr;
+    window::start_frame();
+    ImGui::ShowDemoWindow();
+    window::end_frame();
+
+    double first_frame_ms = -1.0;
+    for (const window::startup_phase& p : window::get_startup_profile()) {
+        if (strcmp(p.name, "time to first frame") == 0) {
+            first_frame_ms = p.duration * 1000.0;
+        }
+    }
+    fputs(window::startup_profile_report(false).c_str(), stdout);
+    window::destroy();
+
+    if (first_frame_ms < 0.0) {
+        fprintf(stderr, "No time to first frame in the profile\n");
+        return 1;
+    }
+    if (budget_ms > 0.0 && first_frame_ms > budget_ms) {
+        fprintf(stderr, "Time to first frame %.1f ms, budget %.1f ms\n",
+                first_frame_ms, budget_ms);
+        return 1;
+    }
+    return 0;
+}
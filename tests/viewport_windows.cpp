@@ -0,0 +1,92 @@
+// Cost of drawing and swapping floating platform windows with OpenGL, with
+// a context per window or with config::shared_gl_context.
+//
+// viewport_windows <windows> [--shared]
+//
+// Needs a display with OpenGL, skipped (exit code 77) without one.
+
+#include "window.h"
+#include "imgui.h"
+#include <SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const int warmup_frames = 30;
+static const int frames = 300;
+
+// Whether init() can create an OpenGL window here
+static bool has_opengl() {
+    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+        return false;
+    }
+    SDL_Window* probe =
+        SDL_CreateWindow("probe", 0, 0, 16, 16,
+                         SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    SDL_GLContext context =
+        probe != nullptr ? SDL_GL_CreateContext(probe) : nullptr;
+    if (context != nullptr) {
+        SDL_GL_DeleteContext(context);
+    }
+    if (probe != nullptr) {
+        SDL_DestroyWindow(probe);
+    }
+    SDL_Quit();
+    return context != nullptr;
+}
+
+int main(int argc, char** argv) {
+    int count = argc > 1 ? atoi(argv[1]) : 1;
+    window::config c;
+    c.backend = window::backend::opengl;
+    c.shared_gl_context = argc > 2 && strcmp(argv[2], "--shared") == 0;
+    // Swaps and switches only, nothing waits for the display
+    c.vsync = false;
+    c.background_fps = 0;
+    c.width = 320;
+    c.height = 240;
+    if (!has_opengl()) {
+        fprintf(stderr, "No OpenGL display, skipped\n");
+        return 77;
+    }
+
+    window::init(c);
+    ImGui::GetIO().IniFilename = nullptr;
+    double frame_ms = 0.0, render_ms = 0.0, swap_ms = 0.0;
+    for (int frame = 0; frame < warmup_frames + frames; frame++) {
+        window::start_frame();
+        ImVec2 origin = ImGui::GetMainViewport()->Pos;
+        for (int i = 0; i < count; i++) {
+            // Beside the main window, so each gets a platform window
+            char name[32];
+            snprintf(name, sizeof(name), "window %d", i);
+            ImGui::SetNextWindowPos(ImVec2(origin.x + c.width + 20.0f +
+                                               (float)(i % 8) * 110.0f,
+                                           origin.y + (float)(i / 8) * 110.0f));
+            ImGui::SetNextWindowSize(ImVec2(100.0f, 100.0f));
+            ImGui::Begin(name);
+            ImGui::Text("frame %d", frame);
+            ImGui::End();
+        }
+        Uint64 begin = SDL_GetPerformanceCounter();
+        window::end_frame();
+        if (frame < warmup_frames) {
+            continue;
+        }
+        frame_ms += (double)(SDL_GetPerformanceCounter() - begin) *
+                    1000.0 / (double)SDL_GetPerformanceFrequency();
+        const std::vector<window::viewport_stats>& stats =
+            window::get_viewport_stats();
+        for (size_t i = 1; i < stats.size(); i++) {
+            render_ms += stats[i].render_ms;
+            swap_ms += stats[i].swap_ms;
+        }
+    }
+    window::destroy();
+
+    printf("%d windows, %s: end_frame() %.3f ms, platform windows draw "
+           "%.3f ms and swap %.3f ms per frame\n",
+           count, c.shared_gl_context ? "shared context" : "own contexts",
+           frame_ms / frames, render_ms / frames, swap_ms / frames);
+    return 0;
+}
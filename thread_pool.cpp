@@ -0,0 +1,120 @@
+#include "thread_pool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace window {
+namespace thread_pool {
+
+namespace {
+
+struct pool {
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::function<void()>> tasks;
+    std::vector<std::thread> threads;
+    bool stopping = false;
+
+    pool() {
+        unsigned int count = std::thread::hardware_concurrency();
+        for (unsigned int i = 1; i < count; i++) {
+            threads.emplace_back([this] { run(); });
+        }
+    }
+
+    ~pool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    void run() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (stopping && tasks.empty()) {
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+};
+
+// Shared with helper tasks that may only get to run after parallel_for()
+// has returned, so it cannot live on the caller's stack.
+struct job {
+    std::function<void(int)> fn;
+    int count;
+    std::atomic<int> next{0};
+    std::atomic<int> finished{0};
+    std::mutex mutex;
+    std::condition_variable done;
+
+    void work() {
+        int n = 0;
+        for (int i; (i = next.fetch_add(1)) < count; n++) {
+            fn(i);
+        }
+        if (n > 0 && finished.fetch_add(n) + n == count) {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.notify_all();
+        }
+    }
+};
+
+pool& instance() {
+    static pool p;
+    return p;
+}
+
+} // namespace
+
+int size() { return (int)instance().threads.size() + 1; }
+
+void parallel_for(int count, const std::function<void(int)>& fn) {
+    if (count <= 0) {
+        return;
+    }
+    pool& p = instance();
+    int helpers = count - 1 < (int)p.threads.size() ? count - 1
+                                                    : (int)p.threads.size();
+    if (helpers == 0) {
+        for (int i = 0; i < count; i++) {
+            fn(i);
+        }
+        return;
+    }
+
+    auto shared = std::make_shared<job>();
+    shared->fn = fn;
+    shared->count = count;
+    {
+        std::lock_guard<std::mutex> lock(p.mutex);
+        for (int i = 0; i < helpers; i++) {
+            p.tasks.push_back([shared] { shared->work(); });
+        }
+    }
+    p.wake.notify_all();
+
+    shared->work();
+    std::unique_lock<std::mutex> lock(shared->mutex);
+    shared->done.wait(lock, [&] { return shared->finished == count; });
+}
+
+} // namespace thread_pool
+} // namespace window
@@ -0,0 +1,18 @@
+#pragma once
+
+// A process wide pool of worker threads, started on first use.
+
+#include <functional>
+
+namespace window {
+namespace thread_pool {
+
+// Number of threads parallel_for() spreads work across, including the caller
+int size();
+
+// Run fn(0) ... fn(count - 1) on the pool and return once all calls have
+// finished. The calling thread takes part, so nested calls cannot deadlock.
+void parallel_for(int count, const std::function<void(int)>& fn);
+
+} // namespace thread_pool
+} // namespace window
@@ -0,0 +1,471 @@
+#include "vulkan_renderer.h"
+
+// Follows imgui's example_sdl_vulkan, using the ImGui_ImplVulkanH_Window
+// helpers for the swapchain, its framebuffers and per frame objects.
+
+#include "disk_cache.h"
+#include "imgui_impl_vulkan.h"
+#include <SDL_vulkan.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// Not in imgui_impl_vulkan.h, but not static either. Unlike
+// ImGui_ImplVulkan_Shutdown() they leave the platform windows alone.
+bool ImGui_ImplVulkan_CreateDeviceObjects();
+void ImGui_ImplVulkan_DestroyDeviceObjects();
+
+namespace window {
+namespace vulkan {
+
+static const char* const pipeline_cache_file = "vulkan_pipeline_cache";
+static const int min_image_count = 2;
+
+static VkAllocationCallbacks* allocator = nullptr;
+static VkInstance instance = VK_NULL_HANDLE;
+static VkPhysicalDevice physical_device = VK_NULL_HANDLE;
+static VkDevice device = VK_NULL_HANDLE;
+static uint32_t queue_family = (uint32_t)-1;
+static VkQueue queue = VK_NULL_HANDLE;
+static VkPipelineCache pipeline_cache = VK_NULL_HANDLE;
+static VkDescriptorPool descriptor_pool = VK_NULL_HANDLE;
+static ImGui_ImplVulkanH_Window main_window;
+static SDL_Window* sdl_window;
+static bool swapchain_rebuild = false;
+// Nothing was submitted this frame, e.g. while minimised
+static bool frame_skipped = false;
+static bool fonts_uploaded = false;
+// One-shot command buffer for font uploads, apart from the frames' own
+static VkCommandPool upload_pool = VK_NULL_HANDLE;
+static VkCommandBuffer upload_buffer = VK_NULL_HANDLE;
+static VkFence upload_fence = VK_NULL_HANDLE;
+
+static void check(VkResult result) {
+    if (result == VK_SUCCESS) {
+        return;
+    }
+    fprintf(stderr, "Vulkan error: VkResult = %d\n", result);
+    if (result < 0) {
+        exit(1);
+    }
+}
+
+static void create_instance() {
+    unsigned int count = 0;
+    if (!SDL_Vulkan_GetInstanceExtensions(sdl_window, &count, nullptr)) {
+        fprintf(stderr, "Error: %s\n", SDL_GetError());
+        exit(1);
+    }
+    std::vector<const char*> extensions(count);
+    SDL_Vulkan_GetInstanceExtensions(sdl_window, &count, extensions.data());
+
+    VkApplicationInfo app = {};
+    app.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    app.pApplicationName = SDL_GetWindowTitle(sdl_window);
+    app.pEngineName = "imgui-boilerplate";
+    app.apiVersion = VK_API_VERSION_1_0;
+    VkInstanceCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    info.pApplicationInfo = &app;
+    info.enabledExtensionCount = count;
+    info.ppEnabledExtensionNames = extensions.data();
+    check(vkCreateInstance(&info, allocator, &instance));
+}
+
+// A queue family that can draw and present to surface
+static bool find_queue_family(VkPhysicalDevice gpu, VkSurfaceKHR surface,
+                              uint32_t* family) {
+    uint32_t count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(gpu, &count, nullptr);
+    std::vector<VkQueueFamilyProperties> families(count);
+    vkGetPhysicalDeviceQueueFamilyProperties(gpu, &count, families.data());
+    for (uint32_t i = 0; i < count; i++) {
+        VkBool32 present = VK_FALSE;
+        vkGetPhysicalDeviceSurfaceSupportKHR(gpu, i, surface, &present);
+        if ((families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) && present) {
+            *family = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Lower is preferred. CPU implementations like lavapipe still work when
+// they are all there is.
+static int device_rank(VkPhysicalDeviceType type) {
+    switch (type) {
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+        return 0;
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+        return 1;
+    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+        return 2;
+    case VK_PHYSICAL_DEVICE_TYPE_CPU:
+        return 3;
+    default:
+        return 4;
+    }
+}
+
+static void select_physical_device(VkSurfaceKHR surface) {
+    uint32_t count = 0;
+    check(vkEnumeratePhysicalDevices(instance, &count, nullptr));
+    std::vector<VkPhysicalDevice> gpus(count);
+    check(vkEnumeratePhysicalDevices(instance, &count, gpus.data()));
+    int best_rank = -1;
+    for (VkPhysicalDevice gpu : gpus) {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(gpu, &properties);
+        int rank = device_rank(properties.deviceType);
+        uint32_t family;
+        if ((best_rank < 0 || rank < best_rank) &&
+            find_queue_family(gpu, surface, &family)) {
+            physical_device = gpu;
+            queue_family = family;
+            best_rank = rank;
+        }
+    }
+    if (best_rank < 0) {
+        fprintf(stderr, "No Vulkan device can present to the window\n");
+        exit(1);
+    }
+}
+
+static void create_device() {
+    const char* extensions[] = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+    const float priority = 1.0f;
+    VkDeviceQueueCreateInfo queue_info = {};
+    queue_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queue_info.queueFamilyIndex = queue_family;
+    queue_info.queueCount = 1;
+    queue_info.pQueuePriorities = &priority;
+    VkDeviceCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    info.queueCreateInfoCount = 1;
+    info.pQueueCreateInfos = &queue_info;
+    info.enabledExtensionCount = 1;
+    info.ppEnabledExtensionNames = extensions;
+    check(vkCreateDevice(physical_device, &info, allocator, &device));
+    vkGetDeviceQueue(device, queue_family, 0, &queue);
+}
+
+// Sized like imgui's example, the font and any user textures come from it
+static void create_descriptor_pool() {
+    const VkDescriptorType types[] = {
+        VK_DESCRIPTOR_TYPE_SAMPLER,
+        VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+        VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+        VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER,
+        VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER,
+        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC,
+        VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT,
+    };
+    const uint32_t type_count = sizeof(types) / sizeof(types[0]);
+    VkDescriptorPoolSize sizes[type_count];
+    for (uint32_t i = 0; i < type_count; i++) {
+        sizes[i].type = types[i];
+        sizes[i].descriptorCount = 1000;
+    }
+    VkDescriptorPoolCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+    info.maxSets = 1000 * type_count;
+    info.poolSizeCount = type_count;
+    info.pPoolSizes = sizes;
+    check(vkCreateDescriptorPool(device, &info, allocator, &descriptor_pool));
+}
+
+// Compiled pipelines from the last run, when they were made by the same
+// driver for the same device. Drivers validate the header too, it is only
+// checked here to skip data they would reject.
+static void create_pipeline_cache() {
+    std::vector<char> data = disk_cache::read(pipeline_cache_file);
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+    // Header: size, version, vendor id, device id, then the cache UUID
+    uint32_t header[4];
+    bool valid = data.size() >= sizeof(header) + VK_UUID_SIZE;
+    if (valid) {
+        memcpy(header, data.data(), sizeof(header));
+        valid = header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+                header[2] == properties.vendorID &&
+                header[3] == properties.deviceID &&
+                memcmp(data.data() + sizeof(header),
+                       properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+    VkPipelineCacheCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    if (valid) {
+        info.initialDataSize = data.size();
+        info.pInitialData = data.data();
+    }
+    check(vkCreatePipelineCache(device, &info, allocator, &pipeline_cache));
+}
+
+static void save_pipeline_cache() {
+    size_t size = 0;
+    check(vkGetPipelineCacheData(device, pipeline_cache, &size, nullptr));
+    std::vector<char> data(size);
+    check(vkGetPipelineCacheData(device, pipeline_cache, &size, data.data()));
+    data.resize(size);
+    disk_cache::write(pipeline_cache_file, data);
+}
+
+static void create_upload_objects() {
+    VkCommandPoolCreateInfo pool = {};
+    pool.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    pool.queueFamilyIndex = queue_family;
+    check(vkCreateCommandPool(device, &pool, allocator, &upload_pool));
+    VkCommandBufferAllocateInfo buffer = {};
+    buffer.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    buffer.commandPool = upload_pool;
+    buffer.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    buffer.commandBufferCount = 1;
+    check(vkAllocateCommandBuffers(device, &buffer, &upload_buffer));
+    VkFenceCreateInfo fence = {};
+    fence.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    check(vkCreateFence(device, &fence, allocator, &upload_fence));
+}
+
+// Create or resize the swapchain to the window's drawable size
+static void resize_swapchain() {
+    int width, height;
+    SDL_Vulkan_GetDrawableSize(sdl_window, &width, &height);
+    ImGui_ImplVulkanH_CreateOrResizeWindow(
+        instance, physical_device, device, &main_window, queue_family,
+        allocator, width, height, min_image_count);
+    main_window.FrameIndex = 0;
+}
+
+static VkPresentModeKHR select_present_mode(VkSurfaceKHR surface, bool vsync,
+                                            bool adaptive_vsync) {
+    // Mailbox keeps only the newest frame queued, latency stays at one
+    // frame without tearing. FIFO is always supported.
+    const VkPresentModeKHR unsynced[] = {VK_PRESENT_MODE_MAILBOX_KHR,
+                                         VK_PRESENT_MODE_FIFO_KHR};
+    const VkPresentModeKHR adaptive[] = {VK_PRESENT_MODE_FIFO_RELAXED_KHR,
+                                         VK_PRESENT_MODE_FIFO_KHR};
+    if (!vsync) {
+        return ImGui_ImplVulkanH_SelectPresentMode(
+            physical_device, surface, unsynced, IM_ARRAYSIZE(unsynced));
+    }
+    if (adaptive_vsync) {
+        return ImGui_ImplVulkanH_SelectPresentMode(
+            physical_device, surface, adaptive, IM_ARRAYSIZE(adaptive));
+    }
+    return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+static void create_swapchain(VkSurfaceKHR surface, bool vsync,
+                             bool adaptive_vsync) {
+    ImGui_ImplVulkanH_Window* wd = &main_window;
+    wd->Surface = surface;
+    const VkFormat formats[] = {
+        VK_FORMAT_B8G8R8A8_UNORM, VK_FORMAT_R8G8B8A8_UNORM,
+        VK_FORMAT_B8G8R8_UNORM, VK_FORMAT_R8G8B8_UNORM};
+    wd->SurfaceFormat = ImGui_ImplVulkanH_SelectSurfaceFormat(
+        physical_device, surface, formats, IM_ARRAYSIZE(formats),
+        VK_COLORSPACE_SRGB_NONLINEAR_KHR);
+    wd->PresentMode = select_present_mode(surface, vsync, adaptive_vsync);
+    resize_swapchain();
+}
+
+void init(SDL_Window* window, bool vsync, bool adaptive_vsync) {
+    sdl_window = window;
+    create_instance();
+    VkSurfaceKHR surface;
+    if (!SDL_Vulkan_CreateSurface(sdl_window, instance, &surface)) {
+        fprintf(stderr, "Error: %s\n", SDL_GetError());
+        exit(1);
+    }
+    select_physical_device(surface);
+    create_device();
+    create_descriptor_pool();
+    create_pipeline_cache();
+    create_upload_objects();
+    create_swapchain(surface, vsync, adaptive_vsync);
+
+    ImGui_ImplVulkan_InitInfo init_info = ImGui_ImplVulkan_InitInfo();
+    init_info.Instance = instance;
+    init_info.PhysicalDevice = physical_device;
+    init_info.Device = device;
+    init_info.QueueFamily = queue_family;
+    init_info.Queue = queue;
+    init_info.PipelineCache = pipeline_cache;
+    init_info.DescriptorPool = descriptor_pool;
+    init_info.MinImageCount = min_image_count;
+    init_info.ImageCount = main_window.ImageCount;
+    init_info.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
+    init_info.Allocator = allocator;
+    init_info.CheckVkResultFn = check;
+    ImGui_ImplVulkan_Init(&init_info, main_window.RenderPass);
+}
+
+void shutdown() {
+    check(vkDeviceWaitIdle(device));
+    save_pipeline_cache();
+    ImGui_ImplVulkan_Shutdown();
+    // Destroys the surface too
+    ImGui_ImplVulkanH_DestroyWindow(instance, device, &main_window,
+                                    allocator);
+    main_window = ImGui_ImplVulkanH_Window();
+    vkDestroyFence(device, upload_fence, allocator);
+    vkDestroyCommandPool(device, upload_pool, allocator);
+    vkDestroyPipelineCache(device, pipeline_cache, allocator);
+    vkDestroyDescriptorPool(device, descriptor_pool, allocator);
+    vkDestroyDevice(device, allocator);
+    vkDestroyInstance(instance, allocator);
+    upload_fence = VK_NULL_HANDLE;
+    upload_buffer = VK_NULL_HANDLE;
+    upload_pool = VK_NULL_HANDLE;
+    pipeline_cache = VK_NULL_HANDLE;
+    descriptor_pool = VK_NULL_HANDLE;
+    device = VK_NULL_HANDLE;
+    instance = VK_NULL_HANDLE;
+    fonts_uploaded = false;
+}
+
+void set_vsync(bool vsync, bool adaptive_vsync) {
+    VkPresentModeKHR mode =
+        select_present_mode(main_window.Surface, vsync, adaptive_vsync);
+    if (mode != main_window.PresentMode) {
+        main_window.PresentMode = mode;
+        swapchain_rebuild = true;
+    }
+}
+
+void upload_fonts() {
+    if (fonts_uploaded) {
+        // Frames in flight may still sample the previous atlas. The backend
+        // keeps a single font image and overwrites it without freeing it,
+        // only destroying its device objects releases the old one.
+        check(vkDeviceWaitIdle(device));
+        ImGui_ImplVulkan_DestroyDeviceObjects();
+        ImGui_ImplVulkan_CreateDeviceObjects();
+    }
+
+    check(vkResetCommandPool(device, upload_pool, 0));
+    VkCommandBufferBeginInfo begin = {};
+    begin.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    check(vkBeginCommandBuffer(upload_buffer, &begin));
+    ImGui_ImplVulkan_CreateFontsTexture(upload_buffer);
+    check(vkEndCommandBuffer(upload_buffer));
+    VkSubmitInfo submit = {};
+    submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit.commandBufferCount = 1;
+    submit.pCommandBuffers = &upload_buffer;
+    check(vkQueueSubmit(queue, 1, &submit, upload_fence));
+    check(vkWaitForFences(device, 1, &upload_fence, VK_TRUE, UINT64_MAX));
+    check(vkResetFences(device, 1, &upload_fence));
+    // Only the staging buffer, the font image stays
+    ImGui_ImplVulkan_DestroyFontUploadObjects();
+    fonts_uploaded = true;
+}
+
+void render(ImDrawData* draw_data, const ImVec4& clear_color) {
+    if (swapchain_rebuild) {
+        int width, height;
+        SDL_Vulkan_GetDrawableSize(sdl_window, &width, &height);
+        if (width > 0 && height > 0) {
+            ImGui_ImplVulkan_SetMinImageCount(min_image_count);
+            resize_swapchain();
+            swapchain_rebuild = false;
+        }
+    }
+    frame_skipped = swapchain_rebuild || draw_data->DisplaySize.x <= 0.0f ||
+                    draw_data->DisplaySize.y <= 0.0f;
+    if (frame_skipped) {
+        return;
+    }
+
+    ImGui_ImplVulkanH_Window* wd = &main_window;
+    ImGui_ImplVulkanH_FrameSemaphores* semaphores =
+        &wd->FrameSemaphores[wd->SemaphoreIndex];
+    VkResult result = vkAcquireNextImageKHR(
+        device, wd->Swapchain, UINT64_MAX,
+        semaphores->ImageAcquiredSemaphore, VK_NULL_HANDLE, &wd->FrameIndex);
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+        // A suboptimal image was acquired and its semaphore signalled, it
+        // is presented as usual and the swapchain rebuilt next frame
+        swapchain_rebuild = true;
+        if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+            frame_skipped = true;
+            return;
+        }
+    } else {
+        check(result);
+    }
+
+    // Only blocks when this image's previous frame is still on the GPU
+    ImGui_ImplVulkanH_Frame* fd = &wd->Frames[wd->FrameIndex];
+    check(vkWaitForFences(device, 1, &fd->Fence, VK_TRUE, UINT64_MAX));
+    check(vkResetFences(device, 1, &fd->Fence));
+    check(vkResetCommandPool(device, fd->CommandPool, 0));
+
+    VkCommandBufferBeginInfo begin = {};
+    begin.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    check(vkBeginCommandBuffer(fd->CommandBuffer, &begin));
+    wd->ClearValue.color.float32[0] = clear_color.x * clear_color.w;
+    wd->ClearValue.color.float32[1] = clear_color.y * clear_color.w;
+    wd->ClearValue.color.float32[2] = clear_color.z * clear_color.w;
+    wd->ClearValue.color.float32[3] = clear_color.w;
+    VkRenderPassBeginInfo pass = {};
+    pass.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    pass.renderPass = wd->RenderPass;
+    pass.framebuffer = fd->Framebuffer;
+    pass.renderArea.extent.width = wd->Width;
+    pass.renderArea.extent.height = wd->Height;
+    pass.clearValueCount = 1;
+    pass.pClearValues = &wd->ClearValue;
+    vkCmdBeginRenderPass(fd->CommandBuffer, &pass,
+                         VK_SUBPASS_CONTENTS_INLINE);
+    ImGui_ImplVulkan_RenderDrawData(draw_data, fd->CommandBuffer);
+    vkCmdEndRenderPass(fd->CommandBuffer);
+    check(vkEndCommandBuffer(fd->CommandBuffer));
+
+    VkPipelineStageFlags wait_stage =
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    VkSubmitInfo submit = {};
+    submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit.waitSemaphoreCount = 1;
+    submit.pWaitSemaphores = &semaphores->ImageAcquiredSemaphore;
+    submit.pWaitDstStageMask = &wait_stage;
+    submit.commandBufferCount = 1;
+    submit.pCommandBuffers = &fd->CommandBuffer;
+    submit.signalSemaphoreCount = 1;
+    submit.pSignalSemaphores = &semaphores->RenderCompleteSemaphore;
+    check(vkQueueSubmit(queue, 1, &submit, fd->Fence));
+}
+
+void present() {
+    if (frame_skipped) {
+        return;
+    }
+    ImGui_ImplVulkanH_Window* wd = &main_window;
+    VkPresentInfoKHR info = {};
+    info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    info.waitSemaphoreCount = 1;
+    info.pWaitSemaphores =
+        &wd->FrameSemaphores[wd->SemaphoreIndex].RenderCompleteSemaphore;
+    info.swapchainCount = 1;
+    info.pSwapchains = &wd->Swapchain;
+    info.pImageIndices = &wd->FrameIndex;
+    VkResult result = vkQueuePresentKHR(queue, &info);
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+        swapchain_rebuild = true;
+    } else {
+        check(result);
+    }
+    wd->SemaphoreIndex = (wd->SemaphoreIndex + 1) % wd->ImageCount;
+}
+
+} // namespace vulkan
+} // namespace window
@@ -0,0 +1,38 @@
+#pragma once
+
+// Vulkan renderer, built with IMGUI_BOILERPLATE_VULKAN.
+//
+// Draws through imgui_impl_vulkan into a swapchain for the SDL window's
+// surface. Without vsync it presents in mailbox mode where the driver has
+// it, so a finished frame replaces the queued one instead of waiting
+// behind it, and falls back to FIFO. Each swapchain image has its own
+// command buffer and fence, so the CPU only waits when every image is still
+// in flight. The pipeline cache is saved to disk on shutdown and loaded on
+// the next start.
+
+#include "imgui.h"
+#include <SDL.h>
+
+namespace window {
+namespace vulkan {
+
+// With a window created with SDL_WINDOW_VULKAN, after
+// ImGui_ImplSDL2_InitForVulkan()
+void init(SDL_Window* window, bool vsync, bool adaptive_vsync);
+void shutdown();
+
+// Rebuild the swapchain with another present mode before the next frame.
+// Adaptive vsync presents in FIFO relaxed mode, falling back to FIFO.
+void set_vsync(bool vsync, bool adaptive_vsync);
+
+// Upload io.Fonts, and again after switching to another atlas. Waits for
+// the GPU to go idle when replacing an atlas.
+void upload_fonts();
+
+// Record and submit the main window's frame. Platform windows are rendered
+// by ImGui::RenderPlatformWindowsDefault() between render() and present().
+void render(ImDrawData* draw_data, const ImVec4& clear_color);
+void present();
+
+} // namespace vulkan
+} // namespace window
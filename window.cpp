@@ -10,53 +10,30 @@
 // read the top of imgui.cpp.
 // Read online: https://github.com/ocornut/imgui/tree/master/docs
 
-#include "fonts/FiraMono_Regular.h"
-#include "fonts/FiraMono_Medium.h"
-#include "fonts/FiraSans_Regular.h"
+#include "cached_window.h"
+#include "damage.h"
+#include "font_atlas.h"
 #include "imgui.h"
-#include "imgui_impl_opengl3.h"
 #include "imgui_impl_sdl.h"
+#include "opengl.h"
+#include "panel_cache.h"
+#include "renderer.h"
+#include "sdf_font.h"
+#include "software_renderer.h"
+#include "startup_profile.h"
 #include <SDL.h>
+#if defined(IMGUI_BOILERPLATE_VULKAN)
+#include "vulkan_renderer.h"
+#endif
+#include <algorithm>
+#include <future>
+#include <math.h>
 #include <stdio.h>
+#include <string.h>
+#include <thread>
 
-#if defined(IMGUI_IMPL_OPENGL_ES2)
-#include <GLES2/gl2.h>
-// About Desktop OpenGL function loaders:
-//  Modern desktop OpenGL doesn't have a standard portable header file to load
-//  OpenGL function pointers.
-//  Helper libraries are often used for this purpose! Here we are supporting a
-//  few common ones (gl3w, glew, glad).
-//  You may use another loader/header of your choice (glext, glLoadGen, etc.),
-//  or chose to manually implement your own.
-#elif defined(IMGUI_IMPL_OPENGL_LOADER_GL3W)
-// Initialize with gl3wInit()
-#include <GL/gl3w.h>
-#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLEW)
-// Initialize with glewInit()
-#include <GL/glew.h>
-#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLAD)
-// Initialize with gladLoadGL()
-#include <glad/glad.h>
-#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLAD2)
-// Initialize with gladLoadGL(...) or gladLoaderLoadGL()
-#include <glad/gl.h>
-#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLBINDING2)
-// GLFW including OpenGL headers causes ambiguity or multiple definition errors.
-#define GLFW_INCLUDE_NONE
-// Initialize with glbinding::Binding::initialize()
-#include <glbinding/Binding.h>
-#include <glbinding/gl/gl.h>
-using namespace gl;
-#elif defined(IMGUI_IMPL_OPENGL_LOADER_GLBINDING3)
-// GLFW including OpenGL headers causes ambiguity or multiple definition errors.
-#define GLFW_INCLUDE_NONE
-// Initialize with glbinding::initialize()
-#include <glbinding/gl/gl.h>
-#include <glbinding/glbinding.h>
-using namespace gl;
-#else
-#include IMGUI_IMPL_OPENGL_LOADER_CUSTOM
-#endif
+// GImGui, see imgui_config.h
+thread_local ImGuiContext* imgui_boilerplate_context = nullptr;
 
 // state
 static bool is_exiting_value = false;
@@ -66,38 +43,169 @@ static SDL_GLContext gl_context;
 
 namespace window {
 
-static ImFont* heading_font;
-static ImFont* normal_font;
+static backend backend_value = backend::opengl;
+static config config_value;
+// Started on first use, see enable_game_controllers()
+static bool game_controllers_enabled = false;
+static std::vector<SDL_GameController*> game_controllers;
+// Frame limiter, see config::max_fps
+static Uint64 frame_interval;
+static Uint64 next_frame_time;
+// Frame start times for get_frame_timing(), in a ring of the last
+// frame_timing::window frame times
+static double frame_times_ms[frame_timing::window];
+static int frame_time_count;
+static int frame_time_next;
+static Uint64 last_frame_start;
+static frame_timing timing;
+// When start_frame() last read input, see config::max_frames_in_flight
+static Uint64 input_time;
+// Minimised or hidden, frames are not drawn
+static bool suspended = false;
+// Throttled to config::background_fps
+static bool in_background = false;
+static Uint64 background_interval;
+static std::function<bool()> background_callback;
+// How often a suspended window asks background_callback
+static const int suspended_poll_ms = 250;
+// Frames drawn without input, see config::wait_events. Hover highlights
+// and layout take a couple of frames to settle after an event.
+static int idle_frames;
+static const int settle_frames = 3;
+static const int idle_timeout_ms = 500;
+static font_atlas::entry* current_fonts;
+static float display_scale_value = 1.0f;
+static bool display_changed = false;
+// imgui.ini, read on a worker thread during init()
+static std::future<std::vector<char>> settings_file;
+
+struct pushed_font {
+    ImFont* font;
+    float scale;
+    bool sdf;
+};
+
+static std::vector<pushed_font> font_stack;
+static bool sdf_text_active = false;
+
+static frame_stats last_frame_stats;
+static std::vector<viewport_stats> last_viewport_stats;
+// The application renders with the context too, see preserve_gl_state()
+static bool gl_state_shared = false;
+// Framebuffer rectangles redrawn this frame, see damage::update()
+static ImVector<ImVec4> damage_rects;
 
 std::queue<SDL_Keysym> keyboard_input;
 std::string text_input;
-std::vector<ImFont*> fonts;
+
+font_role add_font(const void* compressed_ttf, int compressed_ttf_size,
+                   float size) {
+    return {font_atlas::add_font(
+        {compressed_ttf, compressed_ttf_size, size, nullptr, true})};
+}
+
+// Distance field text needs its own shader, switched with draw callbacks
+static void set_sdf_text(bool active) {
+#if defined(IMGUI_BOILERPLATE_SDF_FONTS)
+    if (active != sdf_text_active) {
+        active ? sdf::begin_text() : sdf::end_text();
+    }
+#endif
+    sdf_text_active = active;
+}
+
+void push_font(font_role role) {
+    push_font(role, font_atlas::get_font(role.id).size);
+}
+
+void push_font(font_role role, float size) {
+    // Roles may share an ImFont at different sizes, ImGui::PushFont() takes
+    // the size from ImFont::Scale so it is set here and restored on pop.
+    ImFont* font = current_fonts->fonts[role.id];
+    // Distance field text needs the OpenGL renderer's shader, and the
+    // atlas to have the distance field font already
+    bool sdf = font_atlas::get_font(role.id).sdf &&
+               backend_value == backend::opengl && !current_fonts->minimal;
+    font_stack.push_back({font, font->Scale, sdf});
+    font->Scale = size * current_fonts->scale / font->FontSize;
+    ImGui::PushFont(font);
+    set_sdf_text(sdf);
+}
+
+void pop_font() {
+    pushed_font pushed = font_stack.back();
+    font_stack.pop_back();
+    pushed.font->Scale = pushed.scale;
+    ImGui::PopFont();
+    set_sdf_text(!font_stack.empty() && font_stack.back().sdf);
+}
 
 void heading(const char* str) {
-    ImGui::PushFont(heading_font);
+    scoped_font font(heading_font);
+    ImGui::Text(str);
+}
+
+void heading(const char* str, float size) {
+    scoped_font font(heading_font, size);
     ImGui::Text(str);
-    ImGui::PopFont();
 }
 
 void text(const char* str) {
-    ImGui::PushFont(normal_font);
+    scoped_font font(text_font);
     ImGui::Text(str);
-    ImGui::PopFont();
 }
 
-void init() {
+void text(const char* str, float size) {
+    scoped_font font(text_font, size);
+    ImGui::Text(str);
+}
 
-    // Setup SDL
-    // (Some versions of SDL before <2.0.10 appears to have
-    // performance/stalling issues on a minority of Windows systems,
-    // depending on whether SDL_INIT_GAMECONTROLLER is enabled or
-    // disabled.. updating to latest version of SDL is recommended!)
-    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_GAMECONTROLLER) !=
-        0) {
-        printf("Error: %s\n", SDL_GetError());
-        exit(-1);
+// Scale fonts are rasterised at for the display the window is on, or the
+// one it opens on before it is created
+static float display_scale() {
+#if defined(__APPLE__)
+    // Window sizes are in points already, rasterise at framebuffer density
+    int window_width, window_height, drawable_width, drawable_height;
+    SDL_GetWindowSize(window_ptr, &window_width, &window_height);
+    SDL_GL_GetDrawableSize(window_ptr, &drawable_width, &drawable_height);
+    return window_width > 0 ? (float)drawable_width / window_width : 1.0f;
+#else
+    float dpi;
+    int display =
+        window_ptr == nullptr ? 0 : SDL_GetWindowDisplayIndex(window_ptr);
+    if (SDL_GetDisplayDPI(display, &dpi, nullptr, nullptr) != 0) {
+        return 1.0f;
     }
+    // The physical DPI on X11, often 10-20% above 96 on monitors the
+    // desktop draws at 1x. Those keep the sizes fonts were registered with.
+    float scale = dpi / 96.0f;
+    return fabsf(scale - 1.0f) < 0.15f ? 1.0f : scale;
+#endif
+}
+
+// Switch to another atlas between frames
+static void use_fonts(font_atlas::entry* fonts) {
+    ImGuiIO& io = ImGui::GetIO();
+    current_fonts = fonts;
+    io.Fonts = fonts->atlas;
+#if defined(__APPLE__)
+    // Glyphs are rasterised in framebuffer pixels but laid out in points
+    io.FontGlobalScale = 1.0f / fonts->scale;
+#endif
+}
 
+// With the main window's context current
+static void set_swap_interval(bool vsync, bool adaptive_vsync) {
+    // -1 fails where the driver has no late swap tearing
+    if (vsync && adaptive_vsync && SDL_GL_SetSwapInterval(-1) == 0) {
+        return;
+    }
+    SDL_GL_SetSwapInterval(vsync ? 1 : 0);
+}
+
+// Create the window with an OpenGL context, returns the GLSL version for
+// the renderer
+static const char* create_gl_window(const config& c) {
     // Decide GL+GLSL versions
 #if defined(IMGUI_IMPL_OPENGL_ES2)
     // GL ES 2.0 + GLSL 100
@@ -128,18 +236,26 @@ void init() {
 
     // Create window with graphics context
     SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
-    SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
-    SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 8);
+    SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, c.depth_bits);
+    SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, c.stencil_bits);
     SDL_WindowFlags window_flags = (SDL_WindowFlags)(
         SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI);
-    window_ptr = SDL_CreateWindow(
-        "Application", SDL_WINDOWPOS_CENTERED,
-        SDL_WINDOWPOS_CENTERED, 1280, 720, window_flags);
-    gl_context = SDL_GL_CreateContext(window_ptr);
-    SDL_GL_MakeCurrent(window_ptr, gl_context);
-    SDL_GL_SetSwapInterval(1); // Enable vsync
+    {
+        startup_profile::scope phase("window");
+        window_ptr = SDL_CreateWindow(
+            c.title, SDL_WINDOWPOS_CENTERED,
+            SDL_WINDOWPOS_CENTERED, c.width, c.height, window_flags);
+    }
+    {
+        startup_profile::scope phase("GL context");
+        gl_context = SDL_GL_CreateContext(window_ptr);
+        SDL_GL_MakeCurrent(window_ptr, gl_context);
+        gl::make_current(gl_context);
+        set_swap_interval(c.vsync, c.adaptive_vsync);
+    }
 
     // Initialize OpenGL loader
+    startup_profile::scope phase("GL loader");
 #if defined(IMGUI_IMPL_OPENGL_LOADER_GL3W)
     bool err = gl3wInit() != 0;
 #elif defined(IMGUI_IMPL_OPENGL_LOADER_GLEW)
@@ -167,10 +283,254 @@ void init() {
         fprintf(stderr, "Failed to initialize OpenGL loader!\n");
         exit(1);
     }
+    return glsl_version;
+}
+
+static bool is_software(backend b) {
+    return b == backend::software || b == backend::software_offscreen;
+}
+
+// Of the window's display, 0 when the driver does not know
+static int refresh_rate() {
+    SDL_DisplayMode mode;
+    int display = SDL_GetWindowDisplayIndex(window_ptr);
+    return SDL_GetCurrentDisplayMode(display, &mode) == 0 ? mode.refresh_rate
+                                                           : 0;
+}
+
+// Performance counter ticks between frames for config::max_fps
+static void update_frame_interval() {
+    int fps = config_value.max_fps;
+    if (fps == config::display_refresh_rate) {
+        fps = refresh_rate();
+    }
+    frame_interval = fps > 0 ? SDL_GetPerformanceFrequency() / fps : 0;
+    background_interval =
+        config_value.background_fps > 0
+            ? SDL_GetPerformanceFrequency() / config_value.background_fps
+            : 0;
+
+    int target_fps = fps;
+    if (target_fps == 0 && config_value.vsync &&
+        !is_software(backend_value)) {
+        target_fps = refresh_rate();
+    }
+    timing.target_ms = target_fps > 0 ? 1000.0 / target_fps : 0.0;
+}
+
+// Start over, e.g. when the pacing changes
+static void reset_frame_timing() {
+    frame_time_count = 0;
+    frame_time_next = 0;
+    last_frame_start = 0;
+    double target_ms = timing.target_ms;
+    timing = {};
+    timing.target_ms = target_ms;
+}
+
+static void record_frame_start(Uint64 now) {
+    if (last_frame_start != 0) {
+        frame_times_ms[frame_time_next] =
+            (double)(now - last_frame_start) * 1000.0 /
+            (double)SDL_GetPerformanceFrequency();
+        frame_time_next = (frame_time_next + 1) % frame_timing::window;
+        frame_time_count =
+            std::min(frame_time_count + 1, (int)frame_timing::window);
+    }
+    last_frame_start = now;
+    if (frame_time_count == 0) {
+        return;
+    }
+
+    double sum = 0.0, max = 0.0;
+    int late = 0;
+    for (int i = 0; i < frame_time_count; i++) {
+        sum += frame_times_ms[i];
+        max = std::max(max, frame_times_ms[i]);
+        if (timing.target_ms > 0.0 &&
+            frame_times_ms[i] > timing.target_ms * 1.5) {
+            late++;
+        }
+    }
+    double mean = sum / frame_time_count;
+    double variance = 0.0;
+    for (int i = 0; i < frame_time_count; i++) {
+        double d = frame_times_ms[i] - mean;
+        variance += d * d;
+    }
+    timing.frames = frame_time_count;
+    timing.mean_ms = mean;
+    timing.jitter_ms = sqrt(variance / frame_time_count);
+    timing.max_ms = max;
+    timing.late_frames = late;
+}
+
+config config::low_latency() {
+    config c;
+    c.vsync = false;
+    c.max_fps = display_refresh_rate;
+    c.max_frames_in_flight = 1;
+    c.depth_bits = 0;
+    c.stencil_bits = 0;
+    return c;
+}
+
+config config::power_saver() {
+    config c;
+    c.wait_events = true;
+    c.depth_bits = 0;
+    c.stencil_bits = 0;
+    return c;
+}
+
+config config::headless() {
+    config c;
+    c.backend = backend::software_offscreen;
+    c.vsync = false;
+    c.background_fps = 0;
+    c.viewports = false;
+    return c;
+}
+
+void enable_game_controllers() {
+    if (game_controllers_enabled) {
+        return;
+    }
+    game_controllers_enabled = true;
+    // What starting on first use saves, only recorded during startup
+    startup_profile::scope phase("game controllers");
+    if (SDL_InitSubSystem(SDL_INIT_GAMECONTROLLER) != 0) {
+        fprintf(stderr, "Error: %s\n", SDL_GetError());
+    }
+}
+
+void init() { init(config()); }
+
+void init(backend b) {
+    config c;
+    c.backend = b;
+    init(c);
+}
+
+// Empty if the file does not exist
+static std::vector<char> read_file(const char* name) {
+    startup_profile::scope phase("settings file");
+    std::vector<char> data;
+    FILE* f = fopen(name, "rb");
+    if (f == nullptr) {
+        return data;
+    }
+    char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+        data.insert(data.end(), buffer, buffer + n);
+    }
+    fclose(f);
+    return data;
+}
+
+void init(const config& settings) {
+#if !defined(IMGUI_BOILERPLATE_VULKAN)
+    if (settings.backend == backend::vulkan) {
+        fprintf(stderr, "Built without IMGUI_BOILERPLATE_VULKAN\n");
+        exit(1);
+    }
+#endif
+    backend_value = settings.backend;
+    config_value = settings;
+    idle_frames = 0;
+    next_frame_time = 0;
+    suspended = false;
+    in_background = false;
+    reset_frame_timing();
+
+    // Setup SDL
+    // (Some versions of SDL before <2.0.10 appears to have
+    // performance/stalling issues on a minority of Windows systems,
+    // depending on whether SDL_INIT_GAMECONTROLLER is enabled or
+    // disabled.. updating to latest version of SDL is recommended!)
+    // Timers start themselves in SDL_AddTimer(), game controllers are
+    // started on first use.
+    startup_profile::start();
+    // Read here rather than by the first ImGui::NewFrame(), see start_frame()
+    settings_file = std::async(std::launch::async, read_file, "imgui.ini");
+    {
+        startup_profile::scope phase("SDL init");
+        if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+            printf("Error: %s\n", SDL_GetError());
+            exit(-1);
+        }
+    }
+    if (settings.game_controllers) {
+        enable_game_controllers();
+    }
+
+    // Fonts are rasterised for the display the window opens on. The atlases
+    // are owned by font_atlas so they can be swapped when the DPI changes.
+    font_atlas::textures textures = font_atlas::textures::opengl;
+    if (is_software(backend_value)) {
+        textures = font_atlas::textures::software;
+    } else if (backend_value == backend::vulkan) {
+        textures = font_atlas::textures::backend;
+    }
+#if !defined(__APPLE__)
+    // Windows open centred on the first display, its DPI is known before
+    // the window exists. Rasterised on a worker thread while the window,
+    // the context and the renderer's shaders are set up.
+    display_scale_value = display_scale();
+    font_atlas::prepare(display_scale_value, textures);
+#endif
+
+    const char* glsl_version = nullptr;
+    if (backend_value == backend::opengl) {
+        glsl_version = create_gl_window(settings);
+    } else if (backend_value == backend::vulkan) {
+        startup_profile::scope phase("window");
+        window_ptr = SDL_CreateWindow(
+            settings.title, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+            settings.width, settings.height,
+            SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE |
+                SDL_WINDOW_ALLOW_HIGHDPI);
+    } else {
+        // Drawn into the window surface, or nowhere when offscreen
+        Uint32 flags = SDL_WINDOW_RESIZABLE;
+        if (backend_value == backend::software_offscreen) {
+            flags |= SDL_WINDOW_HIDDEN;
+        }
+        startup_profile::scope phase("window");
+        window_ptr = SDL_CreateWindow(
+            settings.title, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+            settings.width, settings.height, flags);
+    }
+
+#if defined(__APPLE__)
+    // The scale is the window's framebuffer density
+    display_scale_value = display_scale();
+    font_atlas::prepare(display_scale_value, textures);
+#else
+    // Rescaled by the first start_frame() if the window manager placed it
+    // on another display
+    display_changed = true;
+#endif
+    // Progressively, start_frame() switches to the atlas once it is ready
+    if (settings.progressive_fonts) {
+        current_fonts =
+            font_atlas::init_progressive(display_scale_value, textures);
+    }
+    if (backend_value == backend::opengl) {
+        startup_profile::scope phase("shaders");
+        renderer::load_shaders(glsl_version);
+    }
+    if (!settings.progressive_fonts) {
+        current_fonts = font_atlas::init(display_scale_value, textures);
+    }
 
     // Setup Dear ImGui context
     IMGUI_CHECKVERSION();
-    ImGui::CreateContext();
+    {
+        startup_profile::scope phase("ImGui context");
+        ImGui::CreateContext(current_fonts->atlas);
+    }
     ImGuiIO& io = ImGui::GetIO();
     (void)io;
     // Enable Keyboard Controls
@@ -180,7 +540,13 @@ void init() {
     // Enable Docking
     io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
     // Enable Multi-Viewport / Platform Windows
-    io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;
+    if (settings.viewports) {
+        io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;
+    }
+    if (is_software(backend_value)) {
+        // Platform windows need a GPU renderer
+        io.ConfigFlags &= ~ImGuiConfigFlags_ViewportsEnable;
+    }
     // io.ConfigViewportsNoAutoMerge = true;
     // io.ConfigViewportsNoTaskBarIcon = true;
 
@@ -197,8 +563,29 @@ void init() {
     }
 
     // Setup Platform/Renderer backends
-    ImGui_ImplSDL2_InitForOpenGL(window_ptr, gl_context);
-    ImGui_ImplOpenGL3_Init(glsl_version);
+    {
+        startup_profile::scope phase("backend init");
+        if (backend_value == backend::vulkan) {
+#if defined(IMGUI_BOILERPLATE_VULKAN)
+            ImGui_ImplSDL2_InitForVulkan(window_ptr);
+            vulkan::init(window_ptr, settings.vsync,
+                         settings.adaptive_vsync);
+#endif
+        } else {
+            // Without a context for the software renderers, only kept for
+            // viewports
+            ImGui_ImplSDL2_InitForOpenGL(window_ptr, gl_context);
+        }
+        if (backend_value == backend::opengl) {
+            renderer::init(glsl_version);
+            renderer::set_max_frames_in_flight(
+                settings.max_frames_in_flight);
+            damage::init(window_ptr);
+            panel_cache::init();
+        } else if (is_software(backend_value)) {
+            software::init();
+        }
+    }
 
     // Load Fonts
     // - If no fonts are loaded, dear imgui will use the default font.
@@ -241,15 +628,15 @@ void init() {
     //
     // IM_ASSERT(font != NULL);
     
-    // default font
-    io.Fonts->AddFontFromMemoryCompressedTTF(FiraMono_Regular_compressed_data,
-                                             FiraMono_Regular_compressed_size, 16.0f);
-
-    heading_font = io.Fonts->AddFontFromMemoryCompressedTTF(FiraSans_Regular_compressed_data,
-                                             FiraSans_Regular_compressed_size, 22.0f);
-
-    normal_font = io.Fonts->AddFontFromMemoryCompressedTTF(FiraSans_Regular_compressed_data,
-                                             FiraSans_Regular_compressed_size, 18.0f);
+    // Our fonts (FiraMono as default, FiraSans for heading() and text())
+    // were added by font_atlas::init() above.
+    use_fonts(current_fonts);
+#if defined(IMGUI_BOILERPLATE_VULKAN)
+    if (backend_value == backend::vulkan) {
+        startup_profile::scope phase("texture upload");
+        vulkan::upload_fonts();
+    }
+#endif
 
     // Style
     style.WindowMenuButtonPosition = -1;
@@ -319,16 +706,145 @@ void init() {
 
     //
     //
+    update_frame_interval();
     SDL_StartTextInput();
 }
 
 bool is_exiting() { return is_exiting_value; }
 
+static void handle_event(const SDL_Event& event) {
+    ImGui_ImplSDL2_ProcessEvent(&event);
+    if (event.type == SDL_QUIT) {
+        is_exiting_value = true;
+    }
+    if (event.type == SDL_WINDOWEVENT &&
+        event.window.event == SDL_WINDOWEVENT_CLOSE &&
+        event.window.windowID == SDL_GetWindowID(window_ptr)) {
+        is_exiting_value = true;
+    }
+    if (event.type == SDL_KEYDOWN) {
+        keyboard_input.push(event.key.keysym);
+    }
+    if (event.type == SDL_TEXTINPUT) {
+        text_input += event.text.text;
+    }
+    // Older SDL does not tell when the window moves to another display,
+    // every move is checked then
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    const Uint8 display_event = SDL_WINDOWEVENT_DISPLAY_CHANGED;
+#else
+    const Uint8 display_event = SDL_WINDOWEVENT_MOVED;
+#endif
+    if (event.type == SDL_WINDOWEVENT &&
+        event.window.windowID == SDL_GetWindowID(window_ptr) &&
+        (event.window.event == display_event ||
+         event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)) {
+        display_changed = true;
+    }
+    // Controllers connected before the subsystem started are added too
+    if (event.type == SDL_CONTROLLERDEVICEADDED) {
+        if (SDL_GameController* controller =
+                SDL_GameControllerOpen(event.cdevice.which)) {
+            game_controllers.push_back(controller);
+        }
+    }
+    if (event.type == SDL_CONTROLLERDEVICEREMOVED) {
+        SDL_GameController* controller =
+            SDL_GameControllerFromInstanceID(event.cdevice.which);
+        auto it = std::find(game_controllers.begin(), game_controllers.end(),
+                            controller);
+        if (controller != nullptr && it != game_controllers.end()) {
+            SDL_GameControllerClose(controller);
+            game_controllers.erase(it);
+        }
+    }
+}
+
+// Sleep until the frame limit allows the next frame. Before polling events,
+// so the frame is built from the newest input.
+static void limit_frame_rate() {
+    Uint64 now = SDL_GetPerformanceCounter();
+    Uint64 interval = frame_interval;
+    if (in_background) {
+        interval = std::max(interval, background_interval);
+    }
+    if (interval == 0) {
+        record_frame_start(now);
+        return;
+    }
+    if (in_background && interval != frame_interval) {
+        // Input, e.g. the window getting focus back, ends the wait at once
+        if (now < next_frame_time) {
+            Uint64 ms = (next_frame_time - now) * 1000 /
+                        SDL_GetPerformanceFrequency();
+            SDL_WaitEventTimeout(nullptr, (int)ms);
+            now = SDL_GetPerformanceCounter();
+        }
+    } else if (now < next_frame_time) {
+        // SDL_Delay() can oversleep by a millisecond, the rest is spun.
+        // Yielding leaves the core to other threads, e.g. font builds.
+        Uint64 ms =
+            (next_frame_time - now) * 1000 / SDL_GetPerformanceFrequency();
+        if (ms > 1) {
+            SDL_Delay((Uint32)(ms - 1));
+        }
+        while ((now = SDL_GetPerformanceCounter()) < next_frame_time) {
+            std::this_thread::yield();
+        }
+    }
+    // A late frame does not make the following ones early
+    next_frame_time = std::max(next_frame_time + interval, now);
+    record_frame_start(now);
+}
+
+static bool background_live() {
+    return background_callback && background_callback();
+}
+
+// Throttle or suspend frames while the application is in the background
+static void update_visibility() {
+    // Hidden on purpose
+    if (backend_value == backend::software_offscreen ||
+        config_value.background_fps == 0) {
+        suspended = false;
+        in_background = false;
+        return;
+    }
+    Uint32 flags = SDL_GetWindowFlags(window_ptr);
+    suspended = (flags & (SDL_WINDOW_MINIMIZED | SDL_WINDOW_HIDDEN)) != 0;
+    if (suspended) {
+        in_background = true;
+    } else {
+        // Platform windows of ours may have the focus
+        in_background =
+            SDL_GetKeyboardFocus() == nullptr && !background_live();
+    }
+}
+
+static void poll_events(SDL_Event& event, int& events) {
+    while (SDL_PollEvent(&event)) {
+        handle_event(event);
+        events++;
+    }
+}
+
 void start_frame() {
 
     ImGuiIO& io = ImGui::GetIO();
     (void)io;
 
+    limit_frame_rate();
+    startup_profile::frame_started();
+    if (io.ConfigFlags & ImGuiConfigFlags_NavEnableGamepad) {
+        enable_game_controllers();
+    }
+    // Wait for the GPU before reading input rather than after, so the
+    // frame is built from the newest input
+    if (backend_value == backend::opengl) {
+        renderer::wait_for_frames_in_flight();
+    }
+    input_time = SDL_GetPerformanceCounter();
+
     // Poll and handle events (inputs, window resize, etc.)
     // You can read the io.WantCaptureMouse, io.WantCaptureKeyboard flags to
     // tell if dear imgui wants to use your inputs.
@@ -339,40 +855,259 @@ void start_frame() {
     // Generally you may always pass all inputs to dear imgui, and hide them
     // from your application based on those two flags.
     SDL_Event event;
-    while (SDL_PollEvent(&event)) {
-        ImGui_ImplSDL2_ProcessEvent(&event);
-        if (event.type == SDL_QUIT) {
-            is_exiting_value = true;
+    int events = 0;
+    if (config_value.wait_events && idle_frames >= settle_frames) {
+        // The UI has caught up with the last input, sleep until the next
+        if (SDL_WaitEventTimeout(&event, idle_timeout_ms)) {
+            handle_event(event);
+            events++;
+        }
+    }
+    poll_events(event, events);
+    update_visibility();
+    // Restoring the window ends the wait at once
+    while (suspended && !is_exiting_value && !background_live()) {
+        if (SDL_WaitEventTimeout(&event, suspended_poll_ms)) {
+            handle_event(event);
+            events++;
+            poll_events(event, events);
         }
-        if (event.type == SDL_WINDOWEVENT &&
-            event.window.event == SDL_WINDOWEVENT_CLOSE &&
-            event.window.windowID == SDL_GetWindowID(window_ptr)) {
-            is_exiting_value = true;
+        update_visibility();
+        next_frame_time = 0;
+    }
+    idle_frames = events > 0 ? 0 : idle_frames + 1;
+
+    if (gl_state_shared) {
+        gl::invalidate();
+    }
+
+    // Moving to a monitor with another DPI rebuilds the fonts on a worker
+    // thread, we keep rendering with the current atlas until it is ready.
+    if (display_changed) {
+        display_scale_value = display_scale();
+        update_frame_interval();
+        display_changed = false;
+    }
+    font_atlas::entry* fonts = font_atlas::update(display_scale_value);
+    if (fonts != current_fonts) {
+        use_fonts(fonts);
+#if defined(IMGUI_BOILERPLATE_VULKAN)
+        if (backend_value == backend::vulkan) {
+            vulkan::upload_fonts();
         }
-        if (event.type == SDL_KEYDOWN) {
-            keyboard_input.push(event.key.keysym);
+#endif
+    }
+
+    if (settings_file.valid()) {
+        std::vector<char> ini;
+        {
+            startup_profile::scope phase("wait for settings");
+            ini = settings_file.get();
         }
-        if (event.type == SDL_TEXTINPUT) {
-            text_input += event.text.text;
+        // Otherwise the first NewFrame() reads io.IniFilename itself
+        if (!ini.empty() && io.IniFilename != nullptr &&
+            strcmp(io.IniFilename, "imgui.ini") == 0) {
+            ImGui::LoadIniSettingsFromMemory(ini.data(), ini.size());
         }
     }
 
     // Start the Dear ImGui frame
-    ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplSDL2_NewFrame(window_ptr);
     ImGui::NewFrame();
 }
 
-void end_frame() {
+// Move ImGui's cursor to where the mouse is now. After ImGui::EndFrame(),
+// everything else keeps reacting to the position read in start_frame().
+static void sample_cursor_late() {
+    ImGuiIO& io = ImGui::GetIO();
+    if (!io.MouseDrawCursor || !ImGui::IsMousePosValid()) {
+        return;
+    }
+    SDL_PumpEvents();
+    int x, y;
+    // In the coordinates imgui's SDL backend uses
+    if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable) {
+        SDL_GetGlobalMouseState(&x, &y);
+    } else if (SDL_GetMouseFocus() == window_ptr) {
+        SDL_GetMouseState(&x, &y);
+    } else {
+        return;
+    }
+    io.MousePos = ImVec2((float)x, (float)y);
+}
+
+static double milliseconds_since(Uint64 begin) {
+    return (double)(SDL_GetPerformanceCounter() - begin) * 1000.0 /
+           (double)SDL_GetPerformanceFrequency();
+}
+
+// Draw to a platform window with the main window's context, see
+// config::shared_gl_context. imgui's SDL backend still creates a context
+// for each, which stays unused.
+static void make_shared_current(ImGuiViewport* viewport) {
+    SDL_GL_MakeCurrent((SDL_Window*)viewport->PlatformHandle, gl_context);
+}
+
+// SDL window ids of the platform windows whose swap interval was set, see
+// config::shared_gl_context
+static std::vector<Uint32> shared_interval_windows;
+
+// Like ImGui::RenderPlatformWindowsDefault(), but every window is drawn
+// before any is swapped. imgui's SDL backend creates the contexts of
+// platform windows with a swap interval of 0, so none of these swaps waits
+// for the display and only the main window's swap after them does. Drawn
+// one after another, each swap could wait for a refresh of its own.
+// Returns true when the main window's swap interval has to be set again.
+static bool render_platform_windows() {
+    ImGuiPlatformIO& platform_io = ImGui::GetPlatformIO();
+    bool shared = config_value.shared_gl_context;
+    size_t first = last_viewport_stats.size();
+    for (int i = 1; i < platform_io.Viewports.Size; i++) {
+        ImGuiViewport* viewport = platform_io.Viewports[i];
+        if (viewport->Flags & ImGuiViewportFlags_Minimized) {
+            continue;
+        }
+        Uint64 begin = SDL_GetPerformanceCounter();
+        // Makes the window's context current
+        if (shared) {
+            make_shared_current(viewport);
+        } else if (platform_io.Platform_RenderWindow) {
+            platform_io.Platform_RenderWindow(viewport, nullptr);
+        }
+        if (platform_io.Renderer_RenderWindow) {
+            platform_io.Renderer_RenderWindow(viewport, nullptr);
+        }
+        last_viewport_stats.push_back(
+            {viewport->ID, milliseconds_since(begin), 0.0});
+    }
+    size_t index = first;
+    bool opened = false;
+    std::vector<Uint32> interval_windows;
+    for (int i = 1; i < platform_io.Viewports.Size; i++) {
+        ImGuiViewport* viewport = platform_io.Viewports[i];
+        if (viewport->Flags & ImGuiViewportFlags_Minimized) {
+            continue;
+        }
+        Uint64 begin = SDL_GetPerformanceCounter();
+        if (shared) {
+            SDL_Window* sdl_window = (SDL_Window*)viewport->PlatformHandle;
+            Uint32 id = SDL_GetWindowID(sdl_window);
+            make_shared_current(viewport);
+            if (std::find(shared_interval_windows.begin(),
+                          shared_interval_windows.end(),
+                          id) == shared_interval_windows.end()) {
+                SDL_GL_SetSwapInterval(0);
+                opened = true;
+            }
+            interval_windows.push_back(id);
+            SDL_GL_SwapWindow(sdl_window);
+        } else if (platform_io.Platform_SwapBuffers) {
+            platform_io.Platform_SwapBuffers(viewport, nullptr);
+        }
+        if (platform_io.Renderer_SwapBuffers) {
+            platform_io.Renderer_SwapBuffers(viewport, nullptr);
+        }
+        last_viewport_stats[index++].swap_ms = milliseconds_since(begin);
+    }
+    if (shared) {
+        // Minimised windows keep their interval
+        for (int i = 1; i < platform_io.Viewports.Size; i++) {
+            ImGuiViewport* viewport = platform_io.Viewports[i];
+            Uint32 id =
+                SDL_GetWindowID((SDL_Window*)viewport->PlatformHandle);
+            if ((viewport->Flags & ImGuiViewportFlags_Minimized) &&
+                std::find(shared_interval_windows.begin(),
+                          shared_interval_windows.end(),
+                          id) != shared_interval_windows.end()) {
+                interval_windows.push_back(id);
+            }
+        }
+        shared_interval_windows.swap(interval_windows);
+    }
+    return opened;
+}
+
+// Render and present the frame
+static void render_frame() {
     keyboard_input = {};
     ImGuiIO& io = ImGui::GetIO();
     (void)io;
+    if (config_value.late_cursor) {
+        ImGui::EndFrame();
+        sample_cursor_late();
+    }
+    cached_windows::end_frame();
     ImGui::Render();
-    glViewport(0, 0, (int)io.DisplaySize.x, (int)io.DisplaySize.y);
-    glClearColor(clear_color.x * clear_color.w, clear_color.y * clear_color.w,
-                 clear_color.z * clear_color.w, clear_color.w);
-    glClear(GL_COLOR_BUFFER_BIT);
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    if (suspended) {
+        // Kept live by the background callback, nothing is visible
+        if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable) {
+            ImGui::UpdatePlatformWindows();
+        }
+        last_frame_stats = {};
+        last_viewport_stats.clear();
+        return;
+    }
+#if defined(IMGUI_BOILERPLATE_VULKAN)
+    if (backend_value == backend::vulkan) {
+        vulkan::render(ImGui::GetDrawData(), clear_color);
+        if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable) {
+            ImGui::UpdatePlatformWindows();
+            ImGui::RenderPlatformWindowsDefault();
+        }
+        vulkan::present();
+        last_frame_stats = {};
+        return;
+    }
+#endif
+    if (is_software(backend_value)) {
+        software::render(ImGui::GetDrawData(), clear_color);
+        if (backend_value == backend::software) {
+            software::present(window_ptr);
+        }
+        last_frame_stats = software::take_stats();
+        return;
+    }
+    if (gl_state_shared) {
+        gl::invalidate();
+    }
+    last_viewport_stats.clear();
+    Uint64 render_begin = SDL_GetPerformanceCounter();
+    panel_cache::render();
+    if (config_value.shared_gl_context &&
+        (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)) {
+        renderer::upload_viewports();
+    }
+    ImDrawData* draw_data = ImGui::GetDrawData();
+    // Other code drawing into the window is invisible to damage tracking
+    bool full_redraw = gl_state_shared;
+    if (full_redraw) {
+        damage::reset();
+        damage_rects.clear();
+    } else {
+        full_redraw = !damage::update(draw_data, damage_rects);
+    }
+    gl::viewport(0, 0, (int)io.DisplaySize.x, (int)io.DisplaySize.y);
+    gl::clear_color(clear_color.x * clear_color.w,
+                    clear_color.y * clear_color.w,
+                    clear_color.z * clear_color.w, clear_color.w);
+    if (full_redraw) {
+        // The renderer leaves scissoring on, and a clip rect behind
+        gl::set_enabled(GL_SCISSOR_TEST, false);
+        glClear(GL_COLOR_BUFFER_BIT);
+        renderer::render(draw_data);
+    } else {
+        int fb_height =
+            (int)(draw_data->DisplaySize.y * draw_data->FramebufferScale.y);
+        gl::set_enabled(GL_SCISSOR_TEST, true);
+        for (const ImVec4& r : damage_rects) {
+            gl::scissor((int)r.x, (int)(fb_height - r.w), (int)(r.z - r.x),
+                        (int)(r.w - r.y));
+            glClear(GL_COLOR_BUFFER_BIT);
+        }
+        renderer::render(draw_data, &damage_rects);
+    }
+    last_viewport_stats.push_back({ImGui::GetMainViewport()->ID,
+                                   milliseconds_since(render_begin), 0.0});
 
     // Update and Render additional Platform Windows
     // (Platform functions may change the current OpenGL context, so we
@@ -383,18 +1118,94 @@ void end_frame() {
         SDL_Window* backup_current_window = SDL_GL_GetCurrentWindow();
         SDL_GLContext backup_current_context = SDL_GL_GetCurrentContext();
         ImGui::UpdatePlatformWindows();
-        ImGui::RenderPlatformWindowsDefault();
+        bool interval_changed = render_platform_windows();
         SDL_GL_MakeCurrent(backup_current_window, backup_current_context);
+        gl::make_current(backup_current_context);
+        if (interval_changed) {
+            set_swap_interval(config_value.vsync,
+                              config_value.adaptive_vsync);
+        }
+    }
+    last_frame_stats = renderer::take_stats();
+    Uint64 swap_begin = SDL_GetPerformanceCounter();
+    damage::swap(window_ptr, full_redraw, damage_rects);
+    last_viewport_stats[0].swap_ms = milliseconds_since(swap_begin);
+    renderer::frame_swapped(input_time);
+}
+
+void end_frame() {
+    render_frame();
+    startup_profile::finish();
+}
+
+const frame_stats& get_frame_stats() { return last_frame_stats; }
+
+const frame_timing& get_frame_timing() { return timing; }
+
+const std::vector<viewport_stats>& get_viewport_stats() {
+    return last_viewport_stats;
+}
+
+void set_background_callback(const std::function<bool()>& fn) {
+    background_callback = fn;
+}
+
+void set_frame_pacing(vsync_mode vsync, int max_fps) {
+    config_value.vsync = vsync != vsync_mode::off;
+    config_value.adaptive_vsync = vsync == vsync_mode::adaptive;
+    config_value.max_fps = max_fps;
+    if (backend_value == backend::opengl) {
+        set_swap_interval(config_value.vsync, config_value.adaptive_vsync);
     }
-    SDL_GL_SwapWindow(window_ptr);
+#if defined(IMGUI_BOILERPLATE_VULKAN)
+    if (backend_value == backend::vulkan) {
+        vulkan::set_vsync(config_value.vsync, config_value.adaptive_vsync);
+    }
+#endif
+    update_frame_interval();
+    next_frame_time = 0;
+    reset_frame_timing();
+}
+
+const uint32_t* software_framebuffer(int* width, int* height) {
+    return software::framebuffer(width, height);
+}
+
+void preserve_gl_state(bool preserve) {
+    gl_state_shared = preserve;
+    renderer::set_preserve_state(preserve);
 }
 
 void destroy() {
-    ImGui_ImplOpenGL3_Shutdown();
+    if (backend_value == backend::opengl) {
+#if defined(IMGUI_BOILERPLATE_SDF_FONTS)
+        sdf::shutdown();
+#endif
+        panel_cache::shutdown();
+        renderer::shutdown();
+    } else if (is_software(backend_value)) {
+        software::shutdown();
+    }
+#if defined(IMGUI_BOILERPLATE_VULKAN)
+    if (backend_value == backend::vulkan) {
+        vulkan::shutdown();
+    }
+#endif
+    cached_windows::shutdown();
     ImGui_ImplSDL2_Shutdown();
     ImGui::DestroyContext();
+    font_atlas::shutdown();
 
-    SDL_GL_DeleteContext(gl_context);
+    if (gl_context != nullptr) {
+        SDL_GL_DeleteContext(gl_context);
+        gl_context = nullptr;
+    }
+    shared_interval_windows.clear();
+    for (SDL_GameController* controller : game_controllers) {
+        SDL_GameControllerClose(controller);
+    }
+    game_controllers.clear();
+    game_controllers_enabled = false;
     SDL_DestroyWindow(window_ptr);
     SDL_Quit();
 }
@@ -3,16 +3,249 @@
 #include <SDL.h>
 #include <functional>
 #include <queue>
+#include <stdint.h>
 #include <string>
+#include <vector>
 
 namespace window {
+
+// Fonts are registered by role before init() and baked into one atlas, a
+// role indexes its font directly.
+struct font_role {
+    int id;
+};
+
+constexpr font_role default_font{0};
+constexpr font_role heading_font{1};
+constexpr font_role text_font{2};
+
+// What draws the UI, chosen at init()
+enum class backend {
+    opengl,
+    // Rasterised on the CPU and copied to the window surface, for machines
+    // without a GPU or OpenGL driver
+    software,
+    // Rasterised on the CPU into software_framebuffer() only, the window is
+    // hidden. With SDL_VIDEODRIVER=dummy this needs no display at all.
+    software_offscreen,
+    // Needs IMGUI_BOILERPLATE_VULKAN, and is then what init() uses
+    vulkan,
+};
+
+// When presenting waits for the display's refresh
+enum class vsync_mode {
+    off,
+    on,
+    // Waits unless the frame missed the refresh, it is then presented at
+    // once and may tear. Falls back to on where the driver lacks it.
+    adaptive,
+};
+
+// Settings for init(). The defaults match init() without arguments, the
+// presets drop what their use case does not need.
+struct config {
+    const char* title = "Application";
+    int width = 1280;
+    int height = 720;
+#if defined(IMGUI_BOILERPLATE_VULKAN)
+    window::backend backend = window::backend::vulkan;
+#else
+    window::backend backend = window::backend::opengl;
+#endif
+    // Wait for the display's refresh when presenting. Without it, frames
+    // are presented as soon as they are drawn.
+    bool vsync = true;
+    // With vsync, see vsync_mode::adaptive
+    bool adaptive_vsync = false;
+    // Frames per second start_frame() waits down to, 0 for no limit or
+    // display_refresh_rate for the refresh rate of the window's display
+    int max_fps = 0;
+    // start_frame() sleeps until there is input once the UI has settled,
+    // waking twice a second for blinking cursors. Applications animating
+    // without input are drawn at that rate too.
+    bool wait_events = false;
+    // Frames per second while no window of the application has keyboard
+    // focus. Minimised and hidden windows are not drawn, start_frame()
+    // waits until they are restored. 0 keeps the normal rate throughout.
+    // See set_background_callback().
+    int background_fps = 10;
+    // Bits of the OpenGL default framebuffer, ImGui uses neither. Only for
+    // applications drawing with depth or stencil tests themselves.
+    int depth_bits = 24;
+    int stencil_bits = 8;
+    // Start SDL's game controller subsystem in init(). Otherwise it starts
+    // on the first frame with ImGuiConfigFlags_NavEnableGamepad set, or at
+    // enable_game_controllers().
+    bool game_controllers = false;
+    // ImGui windows can be dragged out of the main window, OpenGL and
+    // Vulkan only
+    bool viewports = true;
+    // OpenGL only: platform windows are drawn with the main window's
+    // context, switching only the window it draws to, and the vertices of
+    // every window are uploaded in one go. Needs a driver that lets a
+    // context draw to other windows of the same pixel format, which most
+    // do. Platform windows get a swap interval of 0 when they open. Where
+    // the driver keeps the interval per context rather than per window,
+    // the main window's interval is set again right after, so platform
+    // windows then swap with the main window's vsync.
+    bool shared_gl_context = false;
+    // init() returns without waiting for the fonts, the first frames use
+    // ImGui's default font until the registered fonts are built on a
+    // worker thread. The window shows up sooner, at the cost of a visible
+    // font switch.
+    bool progressive_fonts = false;
+    // OpenGL only: frames the GPU may lag behind end_frame(), waited for
+    // with fences before start_frame() reads input. 0 leaves it to the
+    // driver, which may queue two or three with vsync. 1 has the least
+    // input latency, at the cost of CPU and GPU no longer overlapping.
+    int max_frames_in_flight = 0;
+    // With io.MouseDrawCursor, ImGui's cursor is drawn at the mouse
+    // position read just before ImGui::Render() instead of at start_frame()
+    bool late_cursor = false;
+
+    static constexpr int display_refresh_rate = -1;
+
+    // Presents as soon as a frame is drawn, capped at the refresh rate so
+    // the GPU does not draw frames that are never shown, with one frame in
+    // flight
+    static config low_latency();
+    // Draws only in response to input, at the refresh rate
+    static config power_saver();
+    // Software rendered into software_framebuffer() without showing a
+    // window, for tests and screenshots
+    static config headless();
+};
+
+// A phase of init() or the first frame, in seconds since init() was called.
+// Phases on worker threads overlap those of the main thread.
+struct startup_phase {
+    const char* name;
+    double start;
+    double duration;
+    // Recorded on a worker thread. The main thread's phases are the critical
+    // path, "wait for ..." phases show where it blocked on a worker.
+    bool worker;
+};
+
+// Time between frames over the last frame_timing::window frames, measured
+// when start_frame() returns from the frame rate limit
+struct frame_timing {
+    static constexpr int window = 120;
+    int frames;
+    double mean_ms;
+    // Standard deviation of the frame time
+    double jitter_ms;
+    double max_ms;
+    // The frame rate limit, or the refresh rate with vsync. 0 without
+    // either.
+    double target_ms;
+    // Frames taking over 1.5 times target_ms
+    int late_frames;
+};
+
+// Renderer counters of the last frame, every viewport included
+struct frame_stats {
+    // Draw calls issued, after merging adjacent commands
+    int draw_calls;
+    // ImDrawCmds drawn, before merging
+    int draw_commands;
+    // Vertex and index buffer writes, one per viewport
+    int buffer_uploads;
+    size_t upload_bytes;
+    // With config::max_frames_in_flight: how long start_frame() waited for
+    // the GPU, and the time from reading input to the GPU finishing the
+    // frame it waited for. Both are measured in start_frame(), so they are
+    // counted in the stats of the frame after the one being waited for.
+    // The GPU's finish is only seen when start_frame() polls its fence,
+    // which can be later than the GPU actually finished, so the latency
+    // is an upper bound.
+    double gpu_wait_ms;
+    double input_latency_ms;
+};
+
+// Cost of a window in the last frame. The main window comes first, then
+// with ImGuiConfigFlags_ViewportsEnable the platform windows.
+struct viewport_stats {
+    // ImGuiViewport::ID
+    unsigned int id;
+    // Issuing its draw calls
+    double render_ms;
+    // Blocked in its buffer swap
+    double swap_ms;
+};
+
 extern std::queue<SDL_Keysym> keyboard_input;
 extern std::string text_input;
 bool is_exiting();
 void start_frame();
 void end_frame();
+const frame_stats& get_frame_stats();
+const frame_timing& get_frame_timing();
+// OpenGL only, empty with other backends
+const std::vector<viewport_stats>& get_viewport_stats();
+// Asked once per frame while the window is unfocused, and a few times a
+// second while it is minimised or hidden. Returning true keeps frames
+// coming: unfocused at the normal rate, minimised or hidden at
+// config::background_fps without drawing. For panels showing live data.
+void set_background_callback(const std::function<bool()>& fn);
+// Change vsync and the frame rate limit while running, see config::max_fps.
+// start_frame() sleeps to a millisecond before the limit and spins the rest,
+// for benchmarks and high refresh rate displays.
+void set_frame_pacing(vsync_mode vsync, int max_fps);
+// The boilerplate assumes it is the only user of the OpenGL context and
+// skips state changes that are already in effect. Enable this when the
+// application makes OpenGL calls of its own, GL state is then saved and
+// restored around rendering.
+void preserve_gl_state(bool preserve);
 void text(const char* str);
+void text(const char* str, float size);
 void heading(const char*);
+void heading(const char*, float size);
+// compressed_ttf as produced by imgui's binary_to_compressed_c.cpp
+font_role add_font(const void* compressed_ttf, int compressed_ttf_size,
+                   float size);
+void push_font(font_role role);
+void push_font(font_role role, float size);
+void pop_font();
+// Begin()s the window name with fn as its contents. While version and the
+// window's size, scroll and fonts stay the same and it is neither hovered
+// nor focused, fn is skipped and the draw commands it added last time are
+// replayed. For panels that are expensive to submit, fn must not open child
+// windows or popups as their draw lists are not recorded.
+void cached_window(const char* name, uint64_t version,
+                   const std::function<void()>& fn, int flags = 0);
+// Draws fn into a width by height region at the cursor through a texture,
+// which is only rendered again when version, the region's size or the
+// display scale change. For content that is expensive to draw but rarely
+// changes, like plots. Widgets in fn only see input on the frames it runs.
+void cached_panel(const char* id, float width, float height, uint64_t version,
+                  const std::function<void()>& fn);
+// Memory cached_panel() textures may use together, 64 MiB by default
+void set_panel_cache_budget(size_t bytes);
 void init();
+void init(backend b);
+void init(const config& c);
 void destroy();
+// Start SDL's game controller subsystem, which scans for joysticks and
+// loads the controller database. Controllers are opened as they are
+// connected, for the application to read with SDL_GameController*().
+void enable_game_controllers();
+// Startup phases in order, complete once the first end_frame() presented.
+// Printed to stderr then as well when the environment variable
+// IMGUI_BOILERPLATE_STARTUP_PROFILE is set, as JSON when set to "json".
+const std::vector<startup_phase>& get_startup_profile();
+// The profile as a table, or as a JSON array of phases
+std::string startup_profile_report(bool json);
+// 0xAARRGGBB pixels of the last frame drawn by a software backend, rows
+// from the top
+const uint32_t* software_framebuffer(int* width, int* height);
+
+struct scoped_font {
+    explicit scoped_font(font_role role) { push_font(role); }
+    scoped_font(font_role role, float size) { push_font(role, size); }
+    ~scoped_font() { pop_font(); }
+    scoped_font(const scoped_font&) = delete;
+    scoped_font& operator=(const scoped_font&) = delete;
+};
+
 }; // namespace window